@@ -1,5 +1,6 @@
 #include "GLTexture2D.h"
 #include "GLDebug.h"
+#include "TextureStreamer.h"
 #include <stb_image.h>
 
 GLTexture2D::GLTexture2D() {
@@ -72,6 +73,21 @@ void GLTexture2D::load(const std::string& path) {
         m_FilePath = path;  // Update the file path
     }
 }
+std::shared_ptr<GLTexture2D> GLTexture2D::LoadAsync(const std::string& path) {
+    auto texture = std::make_shared<GLTexture2D>();
+    texture->m_FilePath = path;
+    TextureStreamer::Get()->Load(texture, path);
+    return texture;
+}
+
+void GLTexture2D::adopt(unsigned int id, int width, int height, int bpp) {
+    if (m_RendererID != 0) {
+        GLCall(glDeleteTextures(1, &m_RendererID));
+    }
+    m_RendererID = id;
+    size = { width, height, bpp };
+}
+
 GLTexture2D::~GLTexture2D() {
     GLCall(glDeleteTextures(1, &m_RendererID));
 }
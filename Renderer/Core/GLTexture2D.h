@@ -1,4 +1,5 @@
 #pragma once
+#include <memory>
 #include <string>
 #include <glm/glm.hpp>
 #include <unordered_map>
@@ -7,6 +8,8 @@ class GLTexture2D {
 public:
     GLTexture2D();  // Default 1x1 white or empty
     GLTexture2D(const std::string& path);  // Load from file
+    // the 1x1 white placeholder right away, the image from path once TextureStreamer has uploaded it
+    static std::shared_ptr<GLTexture2D> LoadAsync(const std::string& path);
     ~GLTexture2D();
 
     GLTexture2D(const GLTexture2D& other);  // Copy constructor
@@ -18,6 +21,8 @@ public:
     void load(const std::string& path);
     void bind(unsigned int slot = 0) const;
     void unbind() const;
+    // take over an uploaded texture object, the one shown so far is deleted
+    void adopt(unsigned int id, int width, int height, int bpp);
 
     inline int getWidth() const { return size.x; }
     inline int getHeight() const { return size.y; }
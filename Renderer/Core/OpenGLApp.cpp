@@ -98,8 +98,7 @@ void OpenGL_App::SetupResources() {
 	transform = glm::mat4(1.0f);
 	glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &maxTextures);
 	shader_ = std::make_shared<GLShader>("Resources/Shaders/Batch.shader");
-	texture_ = std::make_shared<GLTexture2D>("Resources/Textures/awesomeface.png");
-	textureIDs.insert({ "awesomeface.png",texture_->getID() });
+	texture_ = GLTexture2D::LoadAsync("Resources/Textures/awesomeface.png");  // placeholder until it is uploaded
 	std::vector<int> samplers;
 	samplers.resize(maxTextures);
 	for (int i = 0; i < maxTextures; i++)
@@ -118,6 +117,10 @@ void OpenGL_App::Execute() {
 	double mouse_x, mouse_y;
 
 	while (!glfwWindowShouldClose(window_)) {
+		// GL work the workers posted, bounded so a burst of uploads spreads over several frames
+		TextureStreamer::Get()->Update();
+		TaskManager::Scheduler()->DrainMainThread(mainThreadBudget);
+
 		glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);  // Clear both buffers
 
@@ -204,6 +207,7 @@ void OpenGL_App::UpdateProjectionMatrix(int width, int height) {
 }
 
 void OpenGL_App::Cleanup() {
+	TextureStreamer::Shutdown();
 	CleanupImGui();
 }
 //frambuffer size callback
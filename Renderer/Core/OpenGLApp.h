@@ -6,6 +6,7 @@
 #include <glm/glm.hpp>
 #include "GLShader.h" 
 #include "GLTexture2D.h"
+#include "TextureStreamer.h"
 #include "App.hpp"
 #include "GLDebug.h"
 #include "../imgui/imgui.h"
@@ -13,6 +14,7 @@
 #include "../imgui/imgui_impl_opengl3.h"
 #include "../RenderableObject.h"
 #include "iRenderer.h"
+#include "../../TaskManager/TaskManager.h"
 #include <algorithm>
 #include <vector>
 
@@ -54,7 +56,6 @@ private:
     GLFWwindow* window_;
     std::shared_ptr<GLShader> shader_;
     std::shared_ptr<GLTexture2D> texture_;
-    std::unordered_map<std::string, unsigned int> textureIDs;
     std::vector<Rect> vRects;
 
     bool enableImGui = false;
@@ -67,6 +68,7 @@ private:
     unsigned int screen_width, screen_height;
     std::chrono::steady_clock::time_point lastTabPressTime;
     std::chrono::milliseconds debounceTime = std::chrono::milliseconds(300); // Adjust as needed
+    std::chrono::microseconds mainThreadBudget = std::chrono::microseconds(2000); // per frame for work posted with PostToMain
     float x = 250.0f, y = 100.0f, bx = 100, by = 100;
 };
 
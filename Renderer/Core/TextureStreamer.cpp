@@ -0,0 +1,213 @@
+#include "TextureStreamer.h"
+#include <cstring>
+#include <iostream>
+#include <stb_image.h>
+#include "GLDebug.h"
+#include "../../TaskManager/TaskManager.h"
+
+std::shared_ptr<TextureStreamer> TextureStreamer::streamer = nullptr;
+
+std::shared_ptr<TextureStreamer> TextureStreamer::Get() {
+    if (!streamer)
+        streamer = std::make_shared<TextureStreamer>();
+    return streamer;
+}
+
+void TextureStreamer::Shutdown() {
+    if (streamer) {
+        // queued work may keep the object alive a while longer, but not the buffer
+        streamer->Close();
+        streamer = nullptr;
+    }
+}
+
+TextureStreamer::~TextureStreamer() {
+    Close();  // a no-op after Shutdown, so the last reference may go on any thread then
+}
+
+void TextureStreamer::Close() {
+    if (closed_.exchange(true, std::memory_order_seq_cst)) {
+        return;
+    }
+    // same store then load handshake as Stage, a worker that missed closed_ is counted in staging_
+    uint32_t staging = staging_.load(std::memory_order_seq_cst);
+    while (staging != 0) {
+        staging_.wait(staging, std::memory_order_seq_cst);
+        staging = staging_.load(std::memory_order_seq_cst);
+    }
+    for (size_t slot : in_flight_) {
+        glDeleteSync(slots_[slot].fence);
+        slots_[slot].fence = nullptr;
+        Release(slot);
+    }
+    in_flight_.clear();
+    if (buffer_ != 0) {
+        GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer_));
+        GLCall(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+        GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+        GLCall(glDeleteBuffers(1, &buffer_));
+        buffer_ = 0;
+        mapped_ = nullptr;
+    }
+}
+
+void TextureStreamer::Init() {
+    // buffer storage keeps the mapping valid while the GPU reads from it, coherent so no flush is needed
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    GLCall(glGenBuffers(1, &buffer_));
+    GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer_));
+    GLCall(glBufferStorage(GL_PIXEL_UNPACK_BUFFER, kSlots * kSlotBytes, nullptr, flags));
+    mapped_ = static_cast<unsigned char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, kSlots * kSlotBytes, flags));
+    GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+
+    std::lock_guard<std::mutex> lock(free_mutex_);
+    for (size_t i = 0; i < kSlots; ++i) {
+        slots_[i].offset = i * kSlotBytes;
+        free_slots_.push_back(i);
+    }
+}
+
+void TextureStreamer::Load(const std::shared_ptr<GLTexture2D>& target, const std::string& path) {
+    if (closed_.load(std::memory_order_relaxed)) {
+        return;  // a reference kept past Shutdown, Get hands out the new streamer
+    }
+    if (buffer_ == 0) {
+        Init();
+    }
+    auto request = std::make_shared<Request>();
+    request->target = target;
+    request->path = path;
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    TaskManager::Scheduler()->Spawn([self = shared_from_this(), request]() { self->Decode(request); });
+}
+
+void TextureStreamer::Decode(const std::shared_ptr<Request>& request) {
+    if (closed_.load(std::memory_order_relaxed) || request->target.expired()) {
+        Drop(request);
+        return;  // dropped before we got to it
+    }
+    // the global flip flag is shared with GLTexture2D::load, set this thread's own
+    stbi_set_flip_vertically_on_load_thread(0);
+    request->pixels = stbi_load(request->path.c_str(), &request->width, &request->height, &request->bpp, 4);
+    if (!request->pixels) {
+        std::cerr << "Failed to load texture: " << request->path << std::endl;
+        Drop(request);
+        return;
+    }
+    Stage(request);
+}
+
+void TextureStreamer::Stage(const std::shared_ptr<Request>& request) {
+    if (closed_.load(std::memory_order_relaxed)) {
+        Drop(request);
+        return;  // also ends a RunAfter retry still waiting for a slot
+    }
+    std::shared_ptr<TaskScheduler> scheduler = TaskManager::Scheduler();
+    size_t bytes = static_cast<size_t>(request->width) * request->height * 4;
+    if (bytes <= kSlotBytes) {
+        request->slot = Acquire();
+        if (request->slot == kSlots) {
+            // every slot is still being read by the GPU, try again without holding this worker
+            scheduler->RunAfter(kRetryDelay, [self = shared_from_this(), request]() { self->Stage(request); });
+            return;
+        }
+        // announce the copy before checking closed_, Close either sees us and waits or we see it
+        staging_.fetch_add(1, std::memory_order_seq_cst);
+        bool closed = closed_.load(std::memory_order_seq_cst);
+        if (!closed) {
+            std::memcpy(mapped_ + slots_[request->slot].offset, request->pixels, bytes);
+        }
+        if (staging_.fetch_sub(1, std::memory_order_seq_cst) == 1 && closed_.load(std::memory_order_seq_cst)) {
+            staging_.notify_all();
+        }
+        if (closed) {
+            Drop(request);
+            return;
+        }
+        stbi_image_free(request->pixels);
+        request->pixels = nullptr;
+    }
+    scheduler->PostToMain([self = shared_from_this(), request]() { self->Upload(request); });
+}
+
+void TextureStreamer::Upload(const std::shared_ptr<Request>& request) {
+    std::shared_ptr<GLTexture2D> target = request->target.lock();
+    if (!target || closed_.load(std::memory_order_relaxed)) {
+        // nothing read the slot yet, it can go straight back
+        Drop(request);
+        return;
+    }
+    pending_.fetch_sub(1, std::memory_order_relaxed);
+
+    GLuint id;
+    GLCall(glGenTextures(1, &id));
+    GLCall(glBindTexture(GL_TEXTURE_2D, id));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+    GLCall(glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, request->width, request->height));
+    GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+    if (request->slot != kSlots) {
+        // the pointer argument is an offset into the bound unpack buffer, the call returns before the copy
+        Slot& slot = slots_[request->slot];
+        GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer_));
+        GLCall(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, request->width, request->height,
+            GL_RGBA, GL_UNSIGNED_BYTE, reinterpret_cast<const void*>(slot.offset)));
+        GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        in_flight_.push_back(request->slot);
+    }
+    else {
+        // larger than a slot, copied from client memory
+        GLCall(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, request->width, request->height,
+            GL_RGBA, GL_UNSIGNED_BYTE, request->pixels));
+        stbi_image_free(request->pixels);
+    }
+    GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+
+    // later draws sample the new texture, GL orders them after the upload
+    target->adopt(id, request->width, request->height, request->bpp);
+}
+
+void TextureStreamer::Update() {
+    for (size_t i = 0; i < in_flight_.size();) {
+        Slot& slot = slots_[in_flight_[i]];
+        GLenum state = glClientWaitSync(slot.fence, 0, 0);
+        if (state == GL_ALREADY_SIGNALED || state == GL_CONDITION_SATISFIED) {
+            glDeleteSync(slot.fence);
+            slot.fence = nullptr;
+            Release(in_flight_[i]);
+            in_flight_[i] = in_flight_.back();
+            in_flight_.pop_back();
+        }
+        else {
+            ++i;
+        }
+    }
+}
+
+void TextureStreamer::Drop(const std::shared_ptr<Request>& request) {
+    if (request->slot != kSlots) {
+        Release(request->slot);
+        request->slot = kSlots;
+    }
+    stbi_image_free(request->pixels);
+    request->pixels = nullptr;
+    pending_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+size_t TextureStreamer::Acquire() {
+    std::lock_guard<std::mutex> lock(free_mutex_);
+    if (free_slots_.empty()) {
+        return kSlots;
+    }
+    size_t slot = free_slots_.back();
+    free_slots_.pop_back();
+    return slot;
+}
+
+void TextureStreamer::Release(size_t slot) {
+    std::lock_guard<std::mutex> lock(free_mutex_);
+    free_slots_.push_back(slot);
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include "GLTexture2D.h"
+
+/// <TextureStreamer>
+/// loads textures without stalling the frame: file read and stb decode run on the scheduler workers,
+/// the worker copies the pixels into a slot of a persistent mapped pixel unpack buffer and the GL thread
+/// only issues glTexSubImage2D from that slot, which the driver copies to the texture asynchronously
+/// a slot is reused once the fence behind its upload has signaled, a worker that finds no free slot
+/// retries later on the scheduler timer, an image larger than a slot is uploaded directly
+/// queued work holds a reference to the streamer, Shutdown closes it so that work is dropped
+/// Load, Update, Shutdown and the destructor belong to the GL thread
+/// </TextureStreamer>
+class TextureStreamer : public std::enable_shared_from_this<TextureStreamer> {
+public:
+    static constexpr size_t kSlots = 8;                    // uploads in flight
+    static constexpr size_t kSlotBytes = 1024 * 1024 * 4;  // one 1024x1024 RGBA8 image
+    static constexpr std::chrono::milliseconds kRetryDelay{ 1 };  // wait for a free slot
+
+    TextureStreamer() = default;
+    TextureStreamer(const TextureStreamer& other) = delete;
+    TextureStreamer& operator=(const TextureStreamer& other) = delete;
+    ~TextureStreamer();
+
+    // the streamer of the GL thread
+    static std::shared_ptr<TextureStreamer> Get();
+    // free the ring buffer while the GL context is still current, Get creates a new streamer afterwards
+    // waits for workers copying into the buffer, loads still queued are dropped without touching it
+    static void Shutdown();
+
+    // decode path on a worker and swap it into target once uploaded, target keeps what it shows until then
+    void Load(const std::shared_ptr<GLTexture2D>& target, const std::string& path);
+    // hand the slots whose uploads the GPU has finished back to the workers, call once per frame
+    void Update();
+    // loads that have not reached their texture yet
+    size_t Pending() const { return pending_.load(std::memory_order_relaxed); }
+
+private:
+    struct Request {
+        std::weak_ptr<GLTexture2D> target;
+        std::string path;
+        unsigned char* pixels = nullptr;  // stbi_load result, RGBA8
+        int width = 0, height = 0, bpp = 0;
+        size_t slot = kSlots;             // kSlots while it has none
+    };
+    struct Slot {
+        size_t offset = 0;        // into the ring buffer
+        GLsync fence = nullptr;   // signals when the upload from this slot is done, GL thread only
+    };
+
+    // create and map the ring buffer, GL thread
+    void Init();
+    // stop the workers using the mapping, then unmap and free the ring buffer, GL thread
+    void Close();
+    // drop a request that will not be uploaded
+    void Drop(const std::shared_ptr<Request>& request);
+    // worker side: decode the file
+    void Decode(const std::shared_ptr<Request>& request);
+    // worker side: copy into a free slot and post the upload, or retry later if all are busy
+    void Stage(const std::shared_ptr<Request>& request);
+    // GL thread: create the texture from the slot or the pixels and swap it into the target
+    void Upload(const std::shared_ptr<Request>& request);
+    // a free slot, kSlots if none
+    size_t Acquire();
+    void Release(size_t slot);
+
+    GLuint buffer_ = 0;
+    unsigned char* mapped_ = nullptr;    // persistent coherent write mapping of buffer_
+    Slot slots_[kSlots];
+    std::vector<size_t> in_flight_;      // slots with a pending fence, GL thread only
+    std::mutex free_mutex_;
+    std::vector<size_t> free_slots_;     // guarded by free_mutex_
+    std::atomic<size_t> pending_{ 0 };
+    std::atomic<bool> closed_{ false };  // set by Close, queued work drops its request
+    std::atomic<uint32_t> staging_{ 0 }; // workers copying into mapped_, Close waits for zero
+
+    static std::shared_ptr<TextureStreamer> streamer;
+};
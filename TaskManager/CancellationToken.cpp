@@ -0,0 +1,40 @@
+#include "CancellationToken.h"
+
+CancellationSource::CancellationSource()
+    : state_(std::make_shared<CancellationToken::State>()) {
+}
+
+CancellationSource::CancellationSource(const CancellationToken& parent)
+    : state_(std::make_shared<CancellationToken::State>()) {
+    if (!parent.state_) return;
+    std::lock_guard<std::mutex> lock(parent.state_->mutex);
+    // checked under the lock so a concurrent parent Cancel either sees the link or is seen here
+    if (parent.state_->cancelled.load(std::memory_order_relaxed)) {
+        state_->cancelled.store(true, std::memory_order_relaxed);
+        return;
+    }
+    // drop links to sources that are gone before adding one
+    auto& children = parent.state_->children;
+    std::erase_if(children, [](const std::weak_ptr<CancellationToken::State>& child) { return child.expired(); });
+    children.push_back(state_);
+}
+
+void CancellationSource::Cancel() {
+    Cancel(state_);
+}
+
+void CancellationSource::Cancel(const std::shared_ptr<CancellationToken::State>& state) {
+    std::vector<std::weak_ptr<CancellationToken::State>> children;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->cancelled.exchange(true, std::memory_order_relaxed)) {
+            return;  // already cancelled, so are its children
+        }
+        children.swap(state->children);
+    }
+    for (auto& child : children) {
+        if (auto linked = child.lock()) {
+            Cancel(linked);
+        }
+    }
+}
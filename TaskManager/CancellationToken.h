@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/// <CancellationToken>
+/// read side of a CancellationSource, copied into every task_ the source may cancel
+/// IsCancelled is a single relaxed load so a long Execute can poll it in its inner loop
+/// a default constructed token is never cancelled
+/// </CancellationToken>
+class CancellationToken {
+public:
+    CancellationToken() = default;
+
+    //return if the source was cancelled
+    bool IsCancelled() const {
+        return state_ && state_->cancelled.load(std::memory_order_relaxed);
+    }
+    //return if this token belongs to a source at all
+    bool CanBeCancelled() const { return state_ != nullptr; }
+
+private:
+    friend class CancellationSource;
+
+    struct State {
+        std::atomic<bool> cancelled{ false };
+        std::mutex mutex;
+        std::vector<std::weak_ptr<State>> children; // linked sources, guarded by mutex
+    };
+
+    explicit CancellationToken(std::shared_ptr<State> state) : state_(std::move(state)) {}
+
+    std::shared_ptr<State> state_;
+};
+
+/// <CancellationSource>
+/// cancels every task_ holding one of its tokens, for example all the work of one entity
+/// a source linked to a parent token is cancelled along with the parent
+/// </CancellationSource>
+class CancellationSource {
+public:
+    //a fresh source
+    CancellationSource();
+    //a source that is also cancelled when parent is
+    explicit CancellationSource(const CancellationToken& parent);
+
+    //a token to hand to tasks
+    CancellationToken Token() const { return CancellationToken(state_); }
+    //cancel every token of this source and of the sources linked to it, only the first call does anything
+    void Cancel();
+    //return if Cancel was called, directly or through the parent
+    bool IsCancelled() const { return state_->cancelled.load(std::memory_order_relaxed); }
+
+private:
+    static void Cancel(const std::shared_ptr<CancellationToken::State>& state);
+
+    std::shared_ptr<CancellationToken::State> state_;
+};
@@ -0,0 +1,83 @@
+#include "DeadlineQueue.h"
+#include "SchedulerMetrics.h"
+
+void DeadlineQueue::push(std::shared_ptr<BaseTask> task, DeadlineMissPolicy policy) {
+    int64_t deadline = task->DeadlineNs();
+    std::lock_guard<std::mutex> lock(mutex_);
+    heap_.push(Entry{ deadline, seq_++, MetricsNowNs(), policy, std::move(task) });
+    count_.fetch_add(1, std::memory_order_release);
+}
+
+std::optional<Message> DeadlineQueue::try_pop(int64_t now_ns) {
+    if (count_.load(std::memory_order_acquire) == 0) {
+        return std::nullopt;
+    }
+    std::vector<std::shared_ptr<BaseTask>> dropped;
+    std::optional<Message> msg;
+    int64_t late_ns = 0;  // of the task in msg, reported once the lock is released
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (!heap_.empty()) {
+            Entry entry = heap_.top();
+            heap_.pop();
+            count_.fetch_sub(1, std::memory_order_relaxed);
+
+            late_ns = now_ns + entry.task->EstimateNs() - entry.deadline_ns;
+            if (late_ns > 0) {
+                missed_.fetch_add(1, std::memory_order_relaxed);
+                if (entry.policy == DeadlineMissPolicy::Cancel) {
+                    dropped.push_back(std::move(entry.task));
+                    continue;
+                }
+            }
+            msg = Message{ MessageType::Task, std::move(entry.task), {}, nullptr, {}, entry.enqueued_ns };
+            break;
+        }
+    }
+    // log and cancel outside the lock, a future runs its continuations here
+    if (msg && late_ns > 0) {
+        LOG_WARNING("Task {:016x} will miss its deadline by {} us", msg->task->GetID().value, late_ns / 1000);
+    }
+    for (auto& task : dropped) {
+        LOG_WARNING("Task {:016x} cancelled, it can no longer make its deadline", task->GetID().value);
+        cancelled_.fetch_add(1, std::memory_order_relaxed);
+        task->Cancel();
+    }
+    return msg;
+}
+
+bool DeadlineQueue::empty() const {
+    return count_.load(std::memory_order_acquire) == 0;
+}
+
+size_t DeadlineQueue::size() const {
+    return count_.load(std::memory_order_acquire);
+}
+
+void DeadlineQueue::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    heap_ = {};
+    count_.store(0, std::memory_order_release);
+    missed_.store(0, std::memory_order_relaxed);
+    cancelled_.store(0, std::memory_order_relaxed);
+}
+
+std::vector<std::shared_ptr<BaseTask>> DeadlineQueue::drain() {
+    std::vector<std::shared_ptr<BaseTask>> tasks;
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks.reserve(heap_.size());
+    while (!heap_.empty()) {
+        tasks.push_back(heap_.top().task);
+        heap_.pop();
+    }
+    count_.store(0, std::memory_order_release);
+    return tasks;
+}
+
+uint64_t DeadlineQueue::Missed() const {
+    return missed_.load(std::memory_order_relaxed);
+}
+
+uint64_t DeadlineQueue::Cancelled() const {
+    return cancelled_.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <vector>
+#include "MessageQueue.h"
+#include "SchedulerConfig.h"
+
+/// <DeadlineQueue>
+/// the tasks with a deadline in DispatchMode::EarliestDeadline, ordered earliest deadline first
+/// try_pop applies the DeadlineMissPolicy to every task that can no longer make its deadline,
+/// that is when now plus its estimate is past the deadline. the queue is shared by every
+/// scheduler, so the policy is the one of the scheduler the task was pushed by
+/// </DeadlineQueue>
+class DeadlineQueue {
+public:
+    DeadlineQueue() = default;
+    DeadlineQueue(const DeadlineQueue& other) = delete;
+    DeadlineQueue& operator=(const DeadlineQueue& other) = delete;
+
+    //queue a task that has a deadline, policy applies if it turns out late
+    void push(std::shared_ptr<BaseTask> task, DeadlineMissPolicy policy);
+    //the task with the earliest deadline, nullopt if none is left to run
+    std::optional<Message> try_pop(int64_t now_ns);
+    bool empty() const;
+    size_t size() const;
+    //drop every task and zero the counters
+    void clear();
+    //remove and return every task, earliest deadline first, the counters are kept
+    std::vector<std::shared_ptr<BaseTask>> drain();
+
+    //tasks found past their deadline at dispatch, since the start
+    uint64_t Missed() const;
+    //of those, the ones dropped under DeadlineMissPolicy::Cancel
+    uint64_t Cancelled() const;
+
+private:
+    struct Entry {
+        int64_t deadline_ns;
+        uint64_t seq;          // keeps equal deadlines in push order
+        int64_t enqueued_ns;
+        DeadlineMissPolicy policy;
+        std::shared_ptr<BaseTask> task;
+        bool operator>(const Entry& other) const {
+            return deadline_ns != other.deadline_ns ? deadline_ns > other.deadline_ns : seq > other.seq;
+        }
+    };
+
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap_; // earliest deadline on top
+    uint64_t seq_ = 0;                                       // guarded by mutex_
+    std::atomic<size_t> count_{ 0 };                         // lets workers skip the lock when empty
+    std::atomic<uint64_t> missed_{ 0 };
+    std::atomic<uint64_t> cancelled_{ 0 };
+    mutable std::mutex mutex_;
+};
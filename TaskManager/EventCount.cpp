@@ -0,0 +1,53 @@
+#include "EventCount.h"
+
+uint32_t EventCount::PrepareWait() {
+    waiters_.fetch_add(1, std::memory_order_seq_cst);
+    return epoch_.load(std::memory_order_seq_cst);
+}
+
+void EventCount::CancelWait() {
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void EventCount::Wait(uint32_t key) {
+    epoch_.wait(key, std::memory_order_seq_cst);  // returns at once if a notify already happened
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void EventCount::NotifyOne() {
+    // pairs with the fetch_add in PrepareWait so a waiter either sees the work or gets woken
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_relaxed) != 0) {
+        epoch_.fetch_add(1, std::memory_order_seq_cst);
+        epoch_.notify_one();
+    }
+}
+
+void EventCount::Notify(uint32_t count) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint32_t waiting = waiters_.load(std::memory_order_relaxed);
+    if (waiting == 0 || count == 0) {
+        return;
+    }
+    epoch_.fetch_add(1, std::memory_order_seq_cst);
+    if (count >= waiting) {
+        epoch_.notify_all();
+    }
+    else {
+        for (uint32_t i = 0; i < count; ++i) {
+            epoch_.notify_one();
+        }
+    }
+}
+
+void EventCount::NotifyAll() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_relaxed) != 0) {
+        epoch_.fetch_add(1, std::memory_order_seq_cst);
+        epoch_.notify_all();
+    }
+}
+
+uint32_t EventCount::Waiters() const {
+    return waiters_.load(std::memory_order_relaxed);
+}
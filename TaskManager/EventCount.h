@@ -0,0 +1,34 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+/// <EventCount>
+/// lets threads park until new work is published without a mutex
+/// a waiter calls PrepareWait, re-checks its queues, then Wait or CancelWait
+/// a producer publishes its work first and then calls Notify
+/// </EventCount>
+class EventCount {
+public:
+    EventCount() = default;
+    EventCount(const EventCount& other) = delete;
+    EventCount& operator=(const EventCount& other) = delete;
+    ~EventCount() = default;
+
+    // register as a waiter and return the key to wait on
+    uint32_t PrepareWait();
+    // found work after PrepareWait, unregister
+    void CancelWait();
+    // park until the epoch moves past key
+    void Wait(uint32_t key);
+    // wake one parked thread if any are waiting
+    void NotifyOne();
+    // wake up to count parked threads
+    void Notify(uint32_t count);
+    // wake every parked thread
+    void NotifyAll();
+    // number of threads between PrepareWait and the end of Wait
+    uint32_t Waiters() const;
+private:
+    std::atomic<uint32_t> epoch_{ 0 };    // bumped on every notify that has waiters
+    std::atomic<uint32_t> waiters_{ 0 };  // threads that are parked or about to park
+};
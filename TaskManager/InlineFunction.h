@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template <typename Signature, size_t Capacity = 48>
+class InlineFunction;
+
+/// <InlineFunction>
+/// move only callable kept entirely inside the object, it never allocates
+/// a callable that does not fit in Capacity bytes fails to compile instead of spilling to the heap
+/// </InlineFunction>
+template <typename R, typename... Args, size_t Capacity>
+class InlineFunction<R(Args...), Capacity> {
+public:
+    InlineFunction() = default;
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, InlineFunction>>>
+    InlineFunction(F&& fn) {
+        using Fn = std::decay_t<F>;
+        static_assert(sizeof(Fn) <= Capacity, "callable too large for InlineFunction, capture less or raise Capacity");
+        static_assert(alignof(Fn) <= alignof(std::max_align_t), "callable is over aligned for InlineFunction");
+        static_assert(std::is_nothrow_move_constructible_v<Fn>, "InlineFunction needs a nothrow movable callable");
+        ::new (static_cast<void*>(storage_)) Fn(std::forward<F>(fn));
+        ops_ = &kOps<Fn>;
+    }
+
+    InlineFunction(InlineFunction&& other) noexcept {
+        if (other.ops_) {
+            other.ops_->move(storage_, other.storage_);
+            ops_ = std::exchange(other.ops_, nullptr);
+        }
+    }
+    InlineFunction& operator=(InlineFunction&& other) noexcept {
+        if (this != &other) {
+            reset();
+            if (other.ops_) {
+                other.ops_->move(storage_, other.storage_);
+                ops_ = std::exchange(other.ops_, nullptr);
+            }
+        }
+        return *this;
+    }
+    InlineFunction(const InlineFunction& other) = delete;
+    InlineFunction& operator=(const InlineFunction& other) = delete;
+    ~InlineFunction() { reset(); }
+
+    R operator()(Args... args) {
+        return ops_->invoke(storage_, std::forward<Args>(args)...);
+    }
+    explicit operator bool() const { return ops_ != nullptr; }
+
+    //destroy the held callable
+    void reset() {
+        if (ops_) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+private:
+    // type erased operations, one static table per callable type
+    struct Ops {
+        R(*invoke)(void* self, Args&&... args);
+        void (*move)(void* dst, void* src);  // move construct into dst and destroy src
+        void (*destroy)(void* self);
+    };
+
+    template <typename Fn>
+    static constexpr Ops kOps{
+        [](void* self, Args&&... args) -> R {
+            return (*static_cast<Fn*>(self))(std::forward<Args>(args)...);
+        },
+        [](void* dst, void* src) {
+            ::new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            static_cast<Fn*>(src)->~Fn();
+        },
+        [](void* self) {
+            static_cast<Fn*>(self)->~Fn();
+        },
+    };
+
+    alignas(std::max_align_t) std::byte storage_[Capacity];  // the callable lives here
+    const Ops* ops_ = nullptr;                              // null when empty
+};
@@ -0,0 +1,159 @@
+#pragma once
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <utility>
+#include "TaskScheduler.h"
+
+template <typename T>
+class Job;
+
+/// <JobState>
+/// result of a Job coroutine, shared by the coroutine frame, the Job and every coroutine awaiting it
+/// the result is published from final_suspend, once the coroutine's locals are gone
+/// </JobState>
+template <typename T>
+class JobState : public FutureState<T> {
+public:
+    JobState() : FutureState<T>(nullptr) {}
+
+    //a Job is never queued as a task_, it runs as its coroutine is resumed
+    virtual void Execute() override {}
+
+    //keep what fn returns or throws
+    template <typename Fn>
+    void Set(Fn&& fn) { this->Store(fn); }
+    //wake everyone waiting on the result
+    void Finish() { this->Publish(); }
+};
+
+/// <JobAwaiter>
+/// co_await on a FutureState, the awaiting coroutine is resumed on the pool once the result is ready
+/// </JobAwaiter>
+template <typename T>
+class JobAwaiter {
+public:
+    explicit JobAwaiter(std::shared_ptr<FutureState<T>> state) : state_(std::move(state)) {}
+
+    bool await_ready() const noexcept { return state_->IsReady(); }
+    void await_suspend(std::coroutine_handle<> handle) const {
+        state_->OnReady([handle]() { TaskScheduler::ResumeOnPool(handle); });
+    }
+    //the result by value, the awaiter and the reference to the state go away with the co_await expression
+    T await_resume() const {
+        if constexpr (std::is_void_v<T>) {
+            state_->Value();  // rethrows
+        }
+        else {
+            return state_->Value();
+        }
+    }
+
+private:
+    std::shared_ptr<FutureState<T>> state_;
+};
+
+/// <JobPromiseBase>
+/// promise of a Job, the coroutine starts right away on the calling thread and frees its frame at the end
+/// </JobPromiseBase>
+template <typename T>
+class JobPromiseBase {
+public:
+    JobPromiseBase() : state_(std::make_shared<JobState<T>>()) {}
+
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    auto final_suspend() noexcept {
+        struct FinalAwaiter {
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) const noexcept {
+                // the frame goes first so a waiter that wakes up never sees it half destroyed
+                std::shared_ptr<JobState<T>> state = std::move(state_);
+                handle.destroy();
+                state->Finish();
+            }
+            void await_resume() const noexcept {}
+            std::shared_ptr<JobState<T>>& state_;
+        };
+        return FinalAwaiter{ state_ };
+    }
+    void unhandled_exception() {
+        // rethrown inside Set so it lands in the state like a throwing task_
+        state_->Set([]() -> T { throw; });
+    }
+
+protected:
+    std::shared_ptr<JobState<T>> state_;
+};
+
+template <typename T>
+class JobPromise : public JobPromiseBase<T> {
+public:
+    Job<T> get_return_object();
+    template <typename U>
+    void return_value(U&& value) {
+        this->state_->Set([&]() -> T { return std::forward<U>(value); });
+    }
+};
+
+template <>
+class JobPromise<void> : public JobPromiseBase<void> {
+public:
+    Job<void> get_return_object();
+    void return_void() {
+        this->state_->Set([]() {});
+    }
+};
+
+/// <Job>
+/// coroutine task_, co_await scheduler.Schedule() moves it onto a worker and
+/// co_await scheduler.Delay(dt), another Job or a TaskFuture suspends it without holding any thread
+/// the coroutine runs to its end whether or not the Job is kept, a coroutine that is still waiting
+/// at StopAll is never resumed and its frame is not freed
+/// </Job>
+template <typename T = void>
+class Job {
+public:
+    using promise_type = JobPromise<T>;
+
+    Job() = default;
+
+    //return if this refers to a coroutine
+    bool valid() const { return state_ != nullptr; }
+    //return if the coroutine has finished
+    bool is_ready() const { return state_->IsReady(); }
+    //block until the coroutine has finished, not from a worker that the coroutine may need
+    void wait() const { state_->Wait(); }
+    //block and return the result, rethrows what the coroutine threw
+    decltype(auto) get() const {
+        state_->Wait();
+        if constexpr (std::is_void_v<T>) {
+            state_->Value();
+        }
+        else {
+            return state_->Value();
+        }
+    }
+
+    JobAwaiter<T> operator co_await() const { return JobAwaiter<T>(state_); }
+
+private:
+    friend class JobPromise<T>;
+    explicit Job(std::shared_ptr<JobState<T>> state) : state_(std::move(state)) {}
+
+    std::shared_ptr<JobState<T>> state_;
+};
+
+template <typename T>
+Job<T> JobPromise<T>::get_return_object() {
+    return Job<T>(this->state_);
+}
+
+inline Job<void> JobPromise<void>::get_return_object() {
+    return Job<void>(this->state_);
+}
+
+//co_await a TaskFuture from a Job, the coroutine resumes on the pool once the task_ has run
+template <typename R>
+JobAwaiter<R> operator co_await(const TaskFuture<R>& future) {
+    return JobAwaiter<R>(std::static_pointer_cast<FutureState<R>>(future.task()));
+}
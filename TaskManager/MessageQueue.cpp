@@ -1,41 +1,56 @@
 #include "MessageQueue.h"
+#include "SchedulerMetrics.h"
+
+MessageQueue::MessageQueue()
+    : bins(static_cast<size_t>(PriorityLevel::BLOCKED) + 1) {
+}
 
 MessageQueue::MessageQueue(const MessageQueue& other) {
-    std::lock_guard<std::mutex> lock_this(queueMtx);  // Lock this queue's mutex
+    std::lock_guard<std::mutex> lock_other(other.queueMtx);  // Lock the other queue's mutex
 
     // Copy the contents of the queue
-    queue = other.queue;
+    bins = other.bins;
+    count.store(other.count.load());
+    bin_mask.store(other.bin_mask.load());
 }
 
 MessageQueue& MessageQueue::operator=(const MessageQueue& other) {
     if (this != &other) {  // Self-assignment check
-        std::lock_guard<std::mutex> lock_this(queueMtx);  // Lock this queue's mutex
+        std::scoped_lock lock(queueMtx, other.queueMtx);  // Lock both queues
 
         // Copy the contents of the queue
-        queue = other.queue;
+        bins = other.bins;
+        count.store(other.count.load());
+        bin_mask.store(other.bin_mask.load());
     }
     return *this;
 }
 
 bool MessageQueue::operator==(const MessageQueue& other) {
-    std::lock_guard<std::mutex> lock_this(queueMtx);  // Lock this queue's mutex
+    std::scoped_lock lock(queueMtx, other.queueMtx);  // Lock both queues
 
     // Compare the contents of both queues by size and element-by-element
-    if (queue.size() != other.queue.size()) {
+    if (bins.size() != other.bins.size()) {
         return false;
     }
 
-    // Compare element by element
-    auto this_copy = queue;
-    auto other_copy = other.queue;
-
-    while (!this_copy.empty() && !other_copy.empty()) {
-        if (this_copy.front().type != other_copy.front().type) {
+    for (size_t i = 0; i < bins.size(); ++i) {
+        if (bins[i].size() != other.bins[i].size()) {
             return false;
         }
 
-        this_copy.pop();
-        other_copy.pop();
+        // Compare element by element
+        auto this_copy = bins[i];
+        auto other_copy = other.bins[i];
+
+        while (!this_copy.empty() && !other_copy.empty()) {
+            if (this_copy.front().type != other_copy.front().type) {
+                return false;
+            }
+
+            this_copy.pop();
+            other_copy.pop();
+        }
     }
 
     return true;
@@ -45,33 +60,146 @@ bool MessageQueue::operator!=(const MessageQueue& other) {
     return !(*this ==(other));
 }
 
+size_t MessageQueue::bin_of(const Message& msg) {
+    if (msg.type != MessageType::Task) {
+        return 0;  // control messages jump the queue
+    }
+    if (msg.job) {
+        return static_cast<size_t>(msg.job->GetPriority());
+    }
+    return msg.task ? static_cast<size_t>(msg.task->GetPriority()) : 0;
+}
 
 void MessageQueue::push(const Message& msg) {
-    std::lock_guard<std::mutex> lock(queueMtx);
-    queue.push(msg);
+    {
+        std::lock_guard<std::mutex> lock(queueMtx);
+        size_t index = bin_of(msg);
+        bins[index].push(msg);
+        bins[index].back().enqueued_ns = MetricsNowNs();
+        bin_mask.store(bin_mask.load(std::memory_order_relaxed) | (1u << index), std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_release);
+    }
+    cv.notify_one();
+}
+size_t MessageQueue::push_tasks(std::span<const std::shared_ptr<BaseTask>> tasks) {
+    size_t queued = 0;
+    int64_t now = MetricsNowNs();
+    {
+        std::lock_guard<std::mutex> lock(queueMtx);
+        uint32_t mask = bin_mask.load(std::memory_order_relaxed);
+        for (const auto& task : tasks) {
+            if (!task) continue;
+            size_t bin = static_cast<size_t>(task->GetPriority());
+            if (bin >= bins.size()) continue;  // invalid priority, caller reports it
+            bins[bin].push(Message{ MessageType::Task, task, {}, nullptr, {}, now });
+            mask |= 1u << bin;
+            ++queued;
+        }
+        bin_mask.store(mask, std::memory_order_relaxed);
+        count.fetch_add(queued, std::memory_order_release);
+    }
+    if (queued > 1) {
+        cv.notify_all();
+    }
+    else if (queued == 1) {
+        cv.notify_one();
+    }
+    return queued;
 }
 std::optional<Message> MessageQueue::pop() {
     std::unique_lock<std::mutex> lock(queueMtx);
-    cv.wait(lock, [this] { return !queue.empty(); });
+    cv.wait(lock, [this] { return count.load(std::memory_order_relaxed) != 0; });
 
-    if (!queue.empty()) {
-        Message msg = queue.front();
-        queue.pop();
-        return msg;
+    for (size_t bin = 0; bin < bins.size(); ++bin) {
+        if (!bins[bin].empty()) {
+            return take_front(bin);
+        }
     }
 
     return std::nullopt;  // Return an empty optional if the queue is empty
 }
+std::optional<Message> MessageQueue::try_pop() {
+    if (count.load(std::memory_order_acquire) == 0) {
+        return std::nullopt;  // never wait, callers go steal or park instead
+    }
+    std::lock_guard<std::mutex> lock(queueMtx);
+    for (size_t bin = 0; bin < bins.size(); ++bin) {
+        if (!bins[bin].empty()) {
+            return take_front(bin);
+        }
+    }
+    return std::nullopt;
+}
+std::optional<Message> MessageQueue::try_pop_bin(size_t bin) {
+    uint32_t bit = 1u << bin;
+    if (bin >= bins.size() || (bin_mask.load(std::memory_order_acquire) & bit) == 0) {
+        return std::nullopt;
+    }
+    std::lock_guard<std::mutex> lock(queueMtx);
+    if (bins[bin].empty()) {
+        return std::nullopt;
+    }
+    return take_front(bin);
+}
+Message MessageQueue::take_front(size_t bin) {
+    Message msg = std::move(bins[bin].front());
+    bins[bin].pop();
+    if (bins[bin].empty()) {
+        bin_mask.store(bin_mask.load(std::memory_order_relaxed) & ~(1u << bin), std::memory_order_relaxed);
+    }
+    count.fetch_sub(1, std::memory_order_relaxed);
+    return msg;
+}
 std::optional<Message> MessageQueue::top() {
     std::unique_lock<std::mutex> lock(queueMtx);
-    cv.wait(lock, [this] { return !queue.empty(); });
+    cv.wait(lock, [this] { return count.load(std::memory_order_relaxed) != 0; });
 
-    if (!queue.empty()) {
-        return queue.front();
+    for (auto& bin : bins) {
+        if (!bin.empty()) {
+            return bin.front();
+        }
     }
 
     return std::nullopt;  // Return an empty optional if the queue is empty
 }
+std::vector<size_t> MessageQueue::bin_sizes() const {
+    std::lock_guard<std::mutex> lock(queueMtx);
+    std::vector<size_t> sizes;
+    sizes.reserve(bins.size());
+    for (const auto& bin : bins) {
+        sizes.push_back(bin.size());
+    }
+    return sizes;
+}
+uint32_t MessageQueue::nonempty_bins() const {
+    return bin_mask.load(std::memory_order_acquire);
+}
 bool MessageQueue::empty() const {
-    return queue.empty();
-}
\ No newline at end of file
+    return count.load(std::memory_order_acquire) == 0;
+}
+size_t MessageQueue::size() const {
+    return count.load(std::memory_order_acquire);
+}
+void MessageQueue::clear() {
+    std::lock_guard<std::mutex> lock(queueMtx);
+    for (auto& bin : bins) {
+        std::queue<Message> empty;
+        std::swap(bin, empty);  // clears bin without invalidating vector
+    }
+    bin_mask.store(0, std::memory_order_relaxed);
+    count.store(0, std::memory_order_release);
+}
+std::vector<Message> MessageQueue::drain() {
+    std::vector<Message> messages;
+    std::lock_guard<std::mutex> lock(queueMtx);
+    messages.reserve(count.load(std::memory_order_relaxed));
+    for (auto& bin : bins) {
+        while (!bin.empty()) {
+            messages.push_back(std::move(bin.front()));
+            bin.pop();
+        }
+    }
+    bin_mask.store(0, std::memory_order_relaxed);
+    count.store(0, std::memory_order_release);
+    return messages;
+}
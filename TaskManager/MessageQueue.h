@@ -3,7 +3,16 @@
 #include <queue>
 #include <string>
 #include <optional>
+#include <atomic>
+#include <vector>
+#include <span>
+#include <unordered_map>
 #include "Tasks.h"
+#include "PooledTask.h"
+#include "EventCount.h"
+#include "TaskTrace.h"
+
+class DeadlineQueue;
 
 enum class MessageType {
     Pause,
@@ -19,29 +28,67 @@ struct Message {
     std::shared_ptr<BaseTask> task; // associated task
     std::string msg;  // associated message 
     void* data; //associated data
+    TaskHandle job; // pooled task, set instead of task on the hot path
+    int64_t enqueued_ns = 0; // when the task was queued, for the queue wait metrics
+
+    // the id the task is traced under, the address of whatever actually runs
+    uint64_t TraceId() const {
+        return job ? reinterpret_cast<uintptr_t>(job.get()) : reinterpret_cast<uintptr_t>(task.get());
+    }
+    // priority of the task, control messages count as SCHEDULED
+    PriorityLevel Priority() const {
+        if (job) return job->GetPriority();
+        return task ? task->GetPriority() : PriorityLevel::SCHEDULED;
+    }
 };
 
 
 // MessageQueue that holds messages to be processed by the main thread
+// messages are binned by the priority of their task, pops take the highest priority bin first
 class MessageQueue {
 public:
-    MessageQueue() = default;
+    MessageQueue();
     MessageQueue(const MessageQueue& other);
     MessageQueue& operator=(const MessageQueue& other);
     bool operator==(const MessageQueue& other);
     bool operator!=(const MessageQueue& other);
     std::optional<Message> pop();
+    std::optional<Message> try_pop(); //non-blocking pop
+    std::optional<Message> try_pop_bin(size_t bin); //non-blocking pop from one priority bin
     std::optional<Message> top();
     void push(const Message& msg);
+    // push a batch of tasks under a single lock, returns how many were queued
+    size_t push_tasks(std::span<const std::shared_ptr<BaseTask>> tasks);
     bool empty() const;
+    size_t size() const;
+    // number of messages in each priority bin
+    std::vector<size_t> bin_sizes() const;
+    // bit per priority bin holding at least one message, read without the lock
+    uint32_t nonempty_bins() const;
+    void clear();
+    //remove and return every message, highest priority first
+    std::vector<Message> drain();
 private:
-    std::queue<Message> queue;
+    // bin index for a message, messages without a task go first
+    static size_t bin_of(const Message& msg);
+    // take the front of a bin, queueMtx held
+    Message take_front(size_t bin);
+
+    std::vector<std::queue<Message>> bins; // one FIFO per PriorityLevel
+    std::atomic<size_t> count{ 0 };       // total queued, lets idle workers skip the lock
+    std::atomic<uint32_t> bin_mask{ 0 };  // nonempty bins, written under queueMtx
     std::condition_variable cv;
-    std::mutex queueMtx;
+    mutable std::mutex queueMtx;
 };
 
 //this is a base class to inherit from to share the task queue
 class TaskQueue {
 public:
     static MessageQueue task_queue;
+    static EventCount task_signal; //parked workers wait on this for new work
+    static DeadlineQueue deadline_queue; //tasks with a deadline in DispatchMode::EarliestDeadline
+    static std::atomic<bool> exclusive_running; //an EXCLUSIVE task holds the pool, other tasks wait to start
+    static std::mutex exclusive_mutex; //one EXCLUSIVE task at a time
+    static std::mutex paused_mutex;
+    static std::unordered_map<EntityID, std::shared_ptr<BaseTask>> paused_tasks; //dequeued while paused, held until resumed, guarded by paused_mutex
 };
\ No newline at end of file
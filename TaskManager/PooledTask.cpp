@@ -0,0 +1,59 @@
+#include "PooledTask.h"
+
+static_assert(sizeof(PooledTask) <= TaskPool::kBlockSize, "PooledTask must fit in one TaskPool block");
+
+static thread_local bool cancelling = false;
+
+void PooledTask::Run() {
+    try {
+        fn_();
+    }
+    catch (const std::exception& e) {
+        LOG_ERROR("Error executing task: {}", e.what());
+    }
+    Finish();
+}
+
+void PooledTask::Cancel() {
+    if (state_.load(std::memory_order_relaxed) & kRunOnCancel) {
+        cancelling = true;
+        try {
+            fn_();
+        }
+        catch (const std::exception& e) {
+            LOG_ERROR("Error cancelling task: {}", e.what());
+        }
+        cancelling = false;
+    }
+    Finish();
+}
+
+bool PooledTask::Cancelling() {
+    return cancelling;
+}
+
+void PooledTask::Finish() {
+    fn_.reset();  // release the captures now, handles may keep the task alive much longer
+
+    uint32_t prev = state_.fetch_or(kDone, std::memory_order_acq_rel);
+    if (prev & kWaiting) {
+        state_.notify_all();  // only pay for the wake when someone is waiting
+    }
+}
+
+void PooledTask::Wait() const {
+    uint32_t state = state_.fetch_or(kWaiting, std::memory_order_acq_rel) | kWaiting;
+    while ((state & kDone) == 0) {
+        state_.wait(state, std::memory_order_acquire);
+        state = state_.load(std::memory_order_acquire);
+    }
+}
+
+void* PooledTask::operator new(size_t size) {
+    (void)size;  // always sizeof(PooledTask), checked above
+    return TaskPool::Allocate();
+}
+
+void PooledTask::operator delete(void* block) {
+    TaskPool::Free(block);
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include "InlineFunction.h"
+#include "TaskPool.h"
+#include "Tasks.h"
+
+/// <PooledTask>
+/// lightweight task for the hot path, one cache line with the callable stored inline
+/// allocated from TaskPool, reference counted in place and with its state in a single atomic word
+/// unlike BaseTask it has no id, no virtual calls and cannot be paused
+/// </PooledTask>
+class PooledTask {
+public:
+    using Function = InlineFunction<void(), 40>;
+
+    // create a task holding fn with one reference owned by the caller
+    // with run_on_cancel, Cancel still calls fn so it can cancel what it wraps, see Cancelling
+    template <typename F>
+    static PooledTask* Create(F&& fn, PriorityLevel priority = PriorityLevel::NORMAL, bool run_on_cancel = false) {
+        return new PooledTask(std::forward<F>(fn), priority, run_on_cancel);
+    }
+    PooledTask(const PooledTask& other) = delete;
+    PooledTask& operator=(const PooledTask& other) = delete;
+
+    // run the callable, done is published afterwards even if it threw
+    void Run();
+    // drop the callable unrun and publish done, so Wait returns for a task the scheduler throws away
+    void Cancel();
+    // true while a run_on_cancel task is called from Cancel on this thread
+    static bool Cancelling();
+    // return if the task_ has run
+    bool IsDone() const { return (state_.load(std::memory_order_acquire) & kDone) != 0; }
+    // block until the task_ has run
+    void Wait() const;
+    PriorityLevel GetPriority() const {
+        return static_cast<PriorityLevel>(state_.load(std::memory_order_relaxed) & kPriorityMask);
+    }
+    // when the task_ was last queued, for the queue wait metrics
+    void SetEnqueued(int64_t ns) { enqueued_ns_ = ns; }
+    int64_t EnqueuedNs() const { return enqueued_ns_; }
+
+    void AddRef() { refs_.fetch_add(1, std::memory_order_relaxed); }
+    // drop a reference, the last one returns the block to TaskPool
+    void Release() {
+        if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+
+    static void* operator new(size_t size);
+    static void operator delete(void* block);
+
+private:
+    template <typename F>
+    PooledTask(F&& fn, PriorityLevel priority, bool run_on_cancel)
+        : fn_(std::forward<F>(fn)), state_(static_cast<uint32_t>(priority) | (run_on_cancel ? kRunOnCancel : 0u)) {
+    }
+    ~PooledTask() = default;
+
+    // release the captures and wake the waiters
+    void Finish();
+
+    static constexpr uint32_t kPriorityMask = 0xFF;  // low byte holds the PriorityLevel
+    static constexpr uint32_t kDone = 1u << 8;       // set once Run returns
+    static constexpr uint32_t kWaiting = 1u << 9;    // someone sleeps in Wait, Run must notify
+    static constexpr uint32_t kRunOnCancel = 1u << 10;  // Cancel calls fn_ with Cancelling set
+
+    Function fn_;                               // the callable and its captures
+    std::atomic<uint32_t> refs_{ 1 };          // intrusive reference count
+    mutable std::atomic<uint32_t> state_;      // priority and flags
+    int64_t enqueued_ns_ = 0;                  // set before the push that publishes the task_
+};
+
+/// <TaskHandle>
+/// intrusive reference to a PooledTask, copying bumps the count and never allocates
+/// </TaskHandle>
+class TaskHandle {
+public:
+    TaskHandle() = default;
+    TaskHandle(const TaskHandle& other) : task_(other.task_) {
+        if (task_) task_->AddRef();
+    }
+    TaskHandle(TaskHandle&& other) noexcept : task_(std::exchange(other.task_, nullptr)) {}
+    TaskHandle& operator=(TaskHandle other) noexcept {
+        std::swap(task_, other.task_);
+        return *this;
+    }
+    ~TaskHandle() {
+        if (task_) task_->Release();
+    }
+
+    // take over a reference the caller already owns
+    static TaskHandle Adopt(PooledTask* task) {
+        TaskHandle handle;
+        handle.task_ = task;
+        return handle;
+    }
+    // give up the reference without releasing it, the caller now owns it
+    PooledTask* Detach() { return std::exchange(task_, nullptr); }
+
+    PooledTask* get() const { return task_; }
+    PooledTask* operator->() const { return task_; }
+    explicit operator bool() const { return task_ != nullptr; }
+    // return if the task_ has run
+    bool IsDone() const { return task_->IsDone(); }
+    // block until the task_ has run
+    void Wait() const { task_->Wait(); }
+
+private:
+    PooledTask* task_ = nullptr;
+};
@@ -0,0 +1,136 @@
+#include "SchedulerConfig.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#ifdef _WIN32
+#include <Windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+SchedulerConfig SchedulerConfig::Default() {
+    return SchedulerConfig{};
+}
+
+SchedulerConfig SchedulerConfig::PinnedPerCore() {
+    SchedulerConfig config;
+    std::vector<NumaNode> nodes = CpuTopology::Nodes();
+    for (const NumaNode& node : nodes) {
+        for (int cpu : node.cpus) {
+            config.affinity.push_back({ cpu });
+        }
+    }
+    // leave one cpu for the dispatcher and the submitting thread
+    if (config.affinity.size() > 1) {
+        config.affinity.pop_back();
+    }
+    config.workers = config.affinity.size();
+    config.numa_aware = nodes.size() > 1;
+    return config;
+}
+
+size_t SchedulerConfig::ResolveWorkers() const {
+    if (workers != 0) {
+        return workers;
+    }
+    // hardware_concurrency may report 0 when it cannot tell
+    unsigned int hardware = std::thread::hardware_concurrency();
+    return hardware > 1 ? hardware - 1 : 1;
+}
+
+std::vector<int> CpuTopology::ParseCpuList(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream stream(list);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        if (range.empty()) continue;
+        size_t dash = range.find('-');
+        try {
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        }
+        catch (const std::exception&) {
+            // malformed entry, skip it
+        }
+    }
+    return cpus;
+}
+
+std::vector<NumaNode> CpuTopology::Nodes() {
+    std::vector<NumaNode> nodes;
+#ifdef __linux__
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator("/sys/devices/system/node", error)) {
+        std::string name = entry.path().filename().string();
+        if (name.rfind("node", 0) != 0 || name.size() == 4 ||
+            !std::all_of(name.begin() + 4, name.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            continue;
+        }
+
+        NumaNode node;
+        node.id = std::stoi(name.substr(4));
+        std::string line;
+        std::ifstream cpulist(entry.path() / "cpulist");
+        if (std::getline(cpulist, line)) {
+            node.cpus = ParseCpuList(line);
+        }
+        std::ifstream distance(entry.path() / "distance");
+        for (int hop; distance >> hop;) {
+            node.distance.push_back(hop);
+        }
+        // memory only nodes have nothing to run workers on
+        if (!node.cpus.empty()) {
+            nodes.push_back(std::move(node));
+        }
+    }
+    std::sort(nodes.begin(), nodes.end(), [](const NumaNode& a, const NumaNode& b) { return a.id < b.id; });
+#endif
+    if (nodes.empty()) {
+        NumaNode node;
+        unsigned int hardware = std::thread::hardware_concurrency();
+        for (unsigned int cpu = 0; cpu < std::max(hardware, 1u); ++cpu) {
+            node.cpus.push_back(static_cast<int>(cpu));
+        }
+        nodes.push_back(std::move(node));
+    }
+    return nodes;
+}
+
+int CpuTopology::NodeOf(const std::vector<NumaNode>& nodes, int cpu) {
+    for (const NumaNode& node : nodes) {
+        if (std::find(node.cpus.begin(), node.cpus.end(), cpu) != node.cpus.end()) {
+            return node.id;
+        }
+    }
+    return -1;
+}
+
+bool CpuTopology::Pin(std::thread& thread, const std::vector<int>& cpus) {
+    if (cpus.empty()) return false;
+#ifdef _WIN32
+    DWORD_PTR mask = 0;
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < static_cast<int>(sizeof(DWORD_PTR) * 8)) {
+            mask |= DWORD_PTR(1) << cpu;
+        }
+    }
+    return mask != 0 && SetThreadAffinityMask(thread.native_handle(), mask) != 0;
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    return pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) == 0;
+#else
+    (void)thread;
+    return false;
+#endif
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+//how workers pick the next task_
+enum class DispatchMode {
+    Priority,          // highest PriorityLevel first, deadlines are ignored
+    EarliestDeadline,  // tasks with a deadline go first, earliest deadline first, the rest by priority
+};
+
+//what EarliestDeadline does with a task_ that will miss its deadline
+enum class DeadlineMissPolicy {
+    Report,  // log it, count it and run it anyway
+    Cancel,  // log it, count it and drop it unrun
+};
+
+/// <NumaNode>
+/// a NUMA node and the cpus that belong to it
+/// </NumaNode>
+struct NumaNode {
+    int id = 0;
+    std::vector<int> cpus;
+    std::vector<int> distance; // SLIT distance to every node indexed by node id, empty if unknown
+};
+
+/// <SchedulerConfig>
+/// how TaskScheduler sizes and places its worker pool
+/// workers 0 means one per hardware thread minus the dispatcher, at least one
+/// affinity holds the cpus each worker is pinned to, an empty or missing entry leaves that worker unpinned
+/// with numa_aware set a worker steals from workers on its own node before going to another node
+/// </SchedulerConfig>
+struct SchedulerConfig {
+    size_t workers = 0;
+    std::vector<std::vector<int>> affinity;
+    bool numa_aware = false;
+    DispatchMode dispatch = DispatchMode::Priority;
+    DeadlineMissPolicy miss_policy = DeadlineMissPolicy::Report;
+    bool tsc_clock = false; // read the scheduler clock from an invariant TSC where there is one, see HighResClock::EnableTsc
+
+    //one unpinned worker per hardware thread minus the dispatcher
+    static SchedulerConfig Default();
+    //one worker per cpu (minus the dispatcher) pinned to it, numbered node by node so the pool fills
+    //one socket before the next, and NUMA ordered stealing when the machine has more than one node
+    static SchedulerConfig PinnedPerCore();
+
+    //the worker count to actually create, never 0
+    size_t ResolveWorkers() const;
+};
+
+/// <CpuTopology>
+/// reads the NUMA layout from /sys/devices/system/node on Linux
+/// elsewhere, or when sysfs is missing, the whole machine is reported as node 0
+/// </CpuTopology>
+class CpuTopology {
+public:
+    //every node with at least one cpu, ordered by node id
+    static std::vector<NumaNode> Nodes();
+    //the node cpu belongs to, -1 if unknown
+    static int NodeOf(const std::vector<NumaNode>& nodes, int cpu);
+    //parse a sysfs cpu list such as "0-3,8-11"
+    static std::vector<int> ParseCpuList(const std::string& list);
+    //pin a thread to the given cpus, returns false if the platform refused or does not support it
+    static bool Pin(std::thread& thread, const std::vector<int>& cpus);
+};
@@ -0,0 +1,57 @@
+#include "SchedulerMetrics.h"
+#include <bit>
+
+size_t LatencyHistogram::BucketOf(uint64_t ns) {
+    if (ns < kSubBuckets) {
+        return static_cast<size_t>(ns);  // exact below the first power of two with sub-buckets
+    }
+    int exponent = std::bit_width(ns) - 1;
+    size_t sub = static_cast<size_t>((ns >> (exponent - kSubBucketBits)) & (kSubBuckets - 1));
+    return static_cast<size_t>(exponent - kSubBucketBits + 1) * kSubBuckets + sub;
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(size_t bucket) {
+    if (bucket < kSubBuckets) {
+        return bucket;
+    }
+    int exponent = static_cast<int>(bucket / kSubBuckets) + kSubBucketBits - 1;
+    uint64_t sub = bucket % kSubBuckets;
+    uint64_t width = uint64_t(1) << (exponent - kSubBucketBits);
+    uint64_t lower = (uint64_t(1) << exponent) + sub * width;
+    return lower + (width - 1);
+}
+
+void LatencyHistogram::Add(size_t bucket, uint64_t count) {
+    counts_[bucket] += count;
+    total_ += count;
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < kBuckets; ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    total_ += other.total_;
+}
+
+uint64_t LatencyHistogram::Percentile(double p) const {
+    if (total_ == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(p / 100.0 * static_cast<double>(total_) + 0.5);
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        seen += counts_[i];
+        if (seen >= rank) {
+            return BucketUpperBound(i);
+        }
+    }
+    return Max();
+}
+
+uint64_t LatencyHistogram::Max() const {
+    for (size_t i = kBuckets; i-- > 0;) {
+        if (counts_[i] != 0) {
+            return BucketUpperBound(i);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <thread>
+#include <vector>
+#include "../Utilities/HighResClock.h"
+
+/// <LatencyHistogram>
+/// HDR style log linear histogram of nanosecond durations, 16 linear sub-buckets per power of two
+/// so every recorded value is kept to within about 6 percent. a plain snapshot, not thread safe
+/// </LatencyHistogram>
+class LatencyHistogram {
+public:
+    static constexpr int kSubBucketBits = 4;
+    static constexpr size_t kSubBuckets = size_t(1) << kSubBucketBits;
+    static constexpr size_t kBuckets = (64 - kSubBucketBits + 1) * kSubBuckets;  // covers every uint64_t
+
+    // bucket a value falls in
+    static size_t BucketOf(uint64_t ns);
+    // largest value that falls in the bucket
+    static uint64_t BucketUpperBound(size_t bucket);
+
+    void Add(size_t bucket, uint64_t count);
+    void Merge(const LatencyHistogram& other);
+    uint64_t Count() const { return total_; }
+    // value at or below which p percent (0-100) of the samples lie, 0 when empty
+    uint64_t Percentile(double p) const;
+    // upper bound of the highest non empty bucket
+    uint64_t Max() const;
+
+private:
+    std::array<uint64_t, kBuckets> counts_{};
+    uint64_t total_ = 0;
+};
+
+/// <WorkerCounters>
+/// counters one worker updates as it runs tasks, padded to its own cache lines
+/// only the owning worker writes them (plain load and store, no read-modify-write),
+/// GetMetrics reads them with relaxed loads from any thread
+/// </WorkerCounters>
+struct alignas(64) WorkerCounters {
+    std::atomic<uint64_t> executed{ 0 };
+    std::atomic<uint64_t> stolen{ 0 };
+    std::atomic<uint64_t> cancelled{ 0 };
+    std::atomic<uint64_t> busy_ns{ 0 };
+    std::atomic<int64_t> started_ns{ 0 };   // when the worker began taking tasks
+    std::array<std::atomic<uint64_t>, LatencyHistogram::kBuckets> queue_wait{};
+    std::array<std::atomic<uint64_t>, LatencyHistogram::kBuckets> execution{};
+
+    // owner thread only
+    static void Bump(std::atomic<uint64_t>& counter, uint64_t by = 1) {
+        counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+    }
+    static void Record(std::array<std::atomic<uint64_t>, LatencyHistogram::kBuckets>& histogram, uint64_t ns) {
+        Bump(histogram[LatencyHistogram::BucketOf(ns)]);
+    }
+    // any thread
+    static void Read(const std::array<std::atomic<uint64_t>, LatencyHistogram::kBuckets>& histogram, LatencyHistogram& out) {
+        for (size_t i = 0; i < histogram.size(); ++i) {
+            uint64_t count = histogram[i].load(std::memory_order_relaxed);
+            if (count != 0) out.Add(i, count);
+        }
+    }
+};
+
+// one worker in a SchedulerMetrics snapshot
+struct WorkerMetrics {
+    std::thread::id thread;
+    int64_t queue_depth = 0;   // tasks waiting in its deque
+    uint64_t executed = 0;     // tasks it ran
+    uint64_t stolen = 0;       // tasks it took from other workers
+    uint64_t cancelled = 0;    // BaseTasks it dropped unrun because their token was cancelled
+    uint64_t busy_ns = 0;      // time spent executing tasks
+    uint64_t idle_ns = 0;      // time since it started minus busy_ns (looking for work or parked)
+    LatencyHistogram queue_wait;
+    LatencyHistogram execution;
+};
+
+// snapshot returned by TaskScheduler::GetMetrics, counters are totals since the scheduler started
+struct SchedulerMetrics {
+    std::vector<size_t> bin_depth;        // shared queue depth per PriorityLevel
+    std::vector<WorkerMetrics> workers;
+    LatencyHistogram queue_wait;          // enqueue to start, all workers
+    LatencyHistogram execution;           // start to end, all workers
+    uint64_t deadline_missed = 0;         // EarliestDeadline tasks found past their deadline at dispatch
+    uint64_t deadline_cancelled = 0;      // of those, the ones dropped by DeadlineMissPolicy::Cancel
+};
+
+// monotonic nanoseconds used by the metrics
+inline int64_t MetricsNowNs() {
+    return HighResClock::Now();
+}
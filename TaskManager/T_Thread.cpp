@@ -1,7 +1,12 @@
-
 #include "T_Thread.h"
-std::vector<std::shared_ptr<T_Thread>> T_Thread::thread_pool;
 MessageQueue TaskQueue::task_queue;
+EventCount TaskQueue::task_signal;
+DeadlineQueue TaskQueue::deadline_queue;
+std::atomic<bool> TaskQueue::exclusive_running{ false };
+std::mutex TaskQueue::exclusive_mutex;
+std::mutex TaskQueue::paused_mutex;
+std::unordered_map<EntityID, std::shared_ptr<BaseTask>> TaskQueue::paused_tasks;
+thread_local T_Thread* T_Thread::current_ = nullptr;
 
 T_Thread::T_Thread()
     : t_thread([this]() { this->Worker(); }) {
@@ -10,135 +15,390 @@ T_Thread::T_Thread()
 // Destructor
 T_Thread::~T_Thread() {
     stop();
-    if (t_thread.joinable()) {
-        t_thread.join();
+    join();
+}
+
+bool T_Thread::Pin(const std::vector<int>& cpus) {
+    return CpuTopology::Pin(t_thread, cpus);
+}
+
+// hand over the steal victims and release the worker
+void T_Thread::Start(const std::vector<T_Thread*>& victims, const std::vector<size_t>& tier_ends) {
+    victims_ = victims;
+    tier_ends_ = tier_ends;
+    if (tier_ends_.empty() || tier_ends_.back() != victims_.size()) {
+        tier_ends_.push_back(victims_.size());
     }
+    next_victim_.assign(tier_ends_.size(), 0);
+    counters_.started_ns.store(MetricsNowNs(), std::memory_order_relaxed);
+    started_.store(true, std::memory_order_release);
+    started_.notify_all();
 }
 
-// Set the task_
-void T_Thread::set_task(std::shared_ptr<BaseTask> task_) {
-    std::lock_guard<std::mutex> lock(threadMutex);
-    task_ = task_;
-    queueCV.notify_one();
+// queue a task on this worker
+void T_Thread::set_task(std::shared_ptr<BaseTask> task) {
+    pushMsg(Message{ MessageType::Task, task });
 }
 
 //set the message
 void T_Thread::SetMessage(Message msg) {
     std::lock_guard<std::mutex> lock(threadMutex);
-    message.type = msg.type;
+    if (state_.load(std::memory_order_acquire) == MessageType::Stop) {
+        return;  // a stopped worker stays stopped
+    }
+    state_.store(msg.type, std::memory_order_release);
+    pauseCV.notify_all();     // wake this worker if it is paused
+    task_signal.NotifyAll();  // wake parked workers so they see the new state
 }
 
 // Stop the thread
 void T_Thread::stop() {
     std::lock_guard<std::mutex> lock(threadMutex);
-    message.type = MessageType::Stop;
-    queueCV.notify_one();
+    state_.store(MessageType::Stop, std::memory_order_release);
+    // a worker that was never started is still waiting on started_
+    started_.store(true, std::memory_order_release);
+    started_.notify_all();
+    pauseCV.notify_all();
+    task_signal.NotifyAll();
+}
+
+void T_Thread::join() {
+    if (t_thread.joinable()) {
+        t_thread.join();
+    }
 }
 // Get the thread's status
 Message T_Thread::GetMsg() {
-    std::lock_guard<std::mutex> lock(threadMutex);
-    return message;
+    return Message{ state_.load(std::memory_order_acquire) };
 }
 std::thread::id T_Thread::GetID() const {
     return t_thread.get_id();  // Assuming t_thread is the actual std::thread object
 }
+int64_t T_Thread::QueueDepth() const {
+    int64_t depth = 0;
+    for (const auto& deque : deques_) {
+        depth += deque.size();
+    }
+    return depth;
+}
+T_Thread* T_Thread::Current() {
+    return current_;
+}
+void T_Thread::ReadMetrics(WorkerMetrics& out) const {
+    out.thread = t_thread.get_id();
+    out.queue_depth = QueueDepth();
+    out.executed = counters_.executed.load(std::memory_order_relaxed);
+    out.stolen = counters_.stolen.load(std::memory_order_relaxed);
+    out.cancelled = counters_.cancelled.load(std::memory_order_relaxed);
+    out.busy_ns = counters_.busy_ns.load(std::memory_order_relaxed);
+    int64_t started = counters_.started_ns.load(std::memory_order_relaxed);
+    uint64_t up = started != 0 ? static_cast<uint64_t>(MetricsNowNs() - started) : 0;
+    out.idle_ns = up > out.busy_ns ? up - out.busy_ns : 0;
+    WorkerCounters::Read(counters_.queue_wait, out.queue_wait);
+    WorkerCounters::Read(counters_.execution, out.execution);
+}
+PooledTask* T_Thread::Wrap(std::shared_ptr<BaseTask> task) {
+    PriorityLevel priority = task->GetPriority();
+    return PooledTask::Create([task = std::move(task)] {
+        RunTask(task);
+    }, priority, true);
+}
+void T_Thread::RunTask(const std::shared_ptr<BaseTask>& task) {
+    if (PooledTask::Cancelling() || task->IsCancellationRequested()) {
+        task->Cancel();
+        if (current_) {
+            WorkerCounters::Bump(current_->counters_.cancelled);
+        }
+        return;
+    }
+    if (task->IsPaused()) {
+        std::lock_guard<std::mutex> lock(paused_mutex);
+        // TaskScheduler::ResumeTask clears the flag before it takes the lock, so a resume either
+        // shows here or finds the task in paused_tasks
+        if (task->IsPaused()) {
+            paused_tasks[task->GetID()] = task;
+            return;
+        }
+    }
+    task->Execute();
+    task->SetCompleted();
+}
+
 void T_Thread::pushMsg(const Message& messageIn) {
-    std::unique_lock<std::mutex> lock(queueMutex);
-    msgQ.push(messageIn);
+    if (current_ == this && messageIn.type == MessageType::Task && (messageIn.job || messageIn.task)) {
+        // owner side of the deque, no lock
+        PooledTask* job = messageIn.job ? TaskHandle(messageIn.job).Detach() : Wrap(messageIn.task);
+        job->SetEnqueued(MetricsNowNs());
+        TASK_TRACE_EVENT(Enqueue, reinterpret_cast<uintptr_t>(job));
+        PushLocal(job);
+    }
+    else {
+        TASK_TRACE_EVENT(Enqueue, messageIn.TraceId());
+        task_queue.push(messageIn);  // only the owner may push to the deque
+    }
+    task_signal.NotifyOne();  // wake a parked worker to run or steal it
+}
+
+void T_Thread::pushTasks(std::span<const std::shared_ptr<BaseTask>> tasks) {
+    uint32_t pushed = 0;
+    int64_t now = MetricsNowNs();
+    for (const auto& task : tasks) {
+        if (!task) continue;
+        PooledTask* job = Wrap(task);
+        job->SetEnqueued(now);
+        TASK_TRACE_EVENT(Enqueue, reinterpret_cast<uintptr_t>(job));
+        PushLocal(job);
+        ++pushed;
+    }
+    task_signal.Notify(pushed);  // one wakeup for the whole batch, thieves spread it out
+}
+
+void T_Thread::pushJob(TaskHandle job) {
+    job->SetEnqueued(MetricsNowNs());
+    TASK_TRACE_EVENT(Enqueue, reinterpret_cast<uintptr_t>(job.get()));
+    PushLocal(job.Detach());
+    task_signal.NotifyOne();
+}
+
+void T_Thread::PushLocal(PooledTask* job) {
+    size_t bin = std::min(static_cast<size_t>(job->GetPriority()), kPriorityBins - 1);
+    deques_[bin].push(job);
+    // set after the push so a thief that sees the bit finds the task
+    uint32_t mask = bin_mask_.load(std::memory_order_relaxed);
+    if ((mask & (1u << bin)) == 0) {
+        bin_mask_.store(mask | (1u << bin), std::memory_order_release);
+    }
+}
+
+std::optional<Message> T_Thread::FindWork() {
+    // earliest deadline first
+    if (!deadline_queue.empty()) {
+        if (std::optional<Message> due = deadline_queue.try_pop(MetricsNowNs())) {
+            TASK_TRACE_EVENT(Dispatch, due->TraceId());
+            return due;
+        }
+    }
+
+    // which bins hold work anywhere, the victim masks are hints and may be stale
+    uint32_t bins = bin_mask_.load(std::memory_order_relaxed) | task_queue.nonempty_bins();
+    for (T_Thread* victim : victims_) {
+        bins |= victim->bin_mask_.load(std::memory_order_relaxed);
+    }
+    if (bins == 0) {
+        return std::nullopt;
+    }
+    // BLOCKED only when nothing else is queued
+    if (bins != kBlockedBit) {
+        bins &= ~kBlockedBit;
+    }
+
+    // highest priority first, an aged pick serves the oldest task of the bin that waited longest
+    bool aged = ++dispatches_ % kAgingPeriod == 0;
+    size_t first = aged ? LongestWaiting(bins) : static_cast<size_t>(std::countr_zero(bins));
+    for (size_t bin = first; bins != 0; bin = static_cast<size_t>(std::countr_zero(bins))) {
+        bins &= ~(1u << bin);
+        if (std::optional<Message> msg = TakeFrom(bin, aged && bin == first)) {
+            served_[bin] = dispatches_;
+            return msg;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<Message> T_Thread::TakeFrom(size_t bin, bool oldest) {
+    uint32_t bit = 1u << bin;
+
+    // own deque first, newest task is the one most likely still in cache
+    uint32_t mask = bin_mask_.load(std::memory_order_relaxed);
+    if (mask & bit) {
+        PooledTask* mine = oldest ? deques_[bin].steal() : nullptr;
+        if (!mine) {
+            mine = deques_[bin].pop();
+        }
+        if (mine) {
+            TASK_TRACE_EVENT(Dispatch, reinterpret_cast<uintptr_t>(mine));
+            return Message{ MessageType::Task, nullptr, {}, nullptr, TaskHandle::Adopt(mine), mine->EnqueuedNs() };
+        }
+        // only the owner pushes, so an empty bin stays empty until it pushes again
+        bin_mask_.store(mask & ~bit, std::memory_order_relaxed);
+    }
+
+    // Otherwise check the global task queue
+    if (std::optional<Message> global = task_queue.try_pop_bin(bin)) {
+        TASK_TRACE_EVENT(Dispatch, global->TraceId());
+        return global;
+    }
+
+    // then try stealing the oldest task of this bin from the other workers, nearest tier first, never blocks
+    size_t begin = 0;
+    for (size_t tier = 0; tier < tier_ends_.size(); ++tier) {
+        size_t count = tier_ends_[tier] - begin;
+        for (size_t i = 0; i < count; ++i) {
+            size_t slot = (next_victim_[tier] + i) % count;
+            T_Thread* victim = victims_[begin + slot];
+            if ((victim->bin_mask_.load(std::memory_order_relaxed) & bit) == 0) continue;
+            if (PooledTask* stolen = victim->deques_[bin].steal()) {
+                next_victim_[tier] = (slot + 1) % count;
+                TASK_TRACE_EVENT(Steal, reinterpret_cast<uintptr_t>(stolen));
+                WorkerCounters::Bump(counters_.stolen);
+                return Message{ MessageType::Task, nullptr, {}, nullptr, TaskHandle::Adopt(stolen), stolen->EnqueuedNs() };
+            }
+        }
+        begin = tier_ends_[tier];
+    }
+    return std::nullopt;
+}
+
+size_t T_Thread::LongestWaiting(uint32_t bins) const {
+    uint32_t candidates = bins & ~kBlockedBit;
+    if (candidates == 0) {
+        return static_cast<size_t>(std::countr_zero(bins));
+    }
+    size_t best = static_cast<size_t>(std::countr_zero(candidates));
+    for (uint32_t left = candidates; left != 0; left &= left - 1) {
+        size_t bin = static_cast<size_t>(std::countr_zero(left));
+        if (served_[bin] < served_[best]) {
+            best = bin;
+        }
+    }
+    return best;
+}
+
+void T_Thread::EnterShared() {
+    // Dekker style handshake with EnterExclusive, both sides store then load with seq_cst
+    active_.store(true, std::memory_order_seq_cst);
+    while (exclusive_running.load(std::memory_order_seq_cst)) {
+        active_.store(false, std::memory_order_seq_cst);
+        active_.notify_all();  // the EXCLUSIVE task may be parked on us
+        exclusive_running.wait(true, std::memory_order_seq_cst);
+        active_.store(true, std::memory_order_seq_cst);
+    }
+}
+
+void T_Thread::LeaveShared() {
+    // the other half of the handshake, only pay for the wake while an EXCLUSIVE task is waiting
+    active_.store(false, std::memory_order_seq_cst);
+    if (exclusive_running.load(std::memory_order_seq_cst)) {
+        active_.notify_all();
+    }
+}
+
+void T_Thread::EnterExclusive() {
+    exclusive_mutex.lock();
+    exclusive_running.store(true, std::memory_order_seq_cst);
+    // running tasks finish, none start until LeaveExclusive, a shared task that waits on queued
+    // work never finishes here, see PriorityLevel::EXCLUSIVE
+    for (T_Thread* other : victims_) {
+        other->active_.wait(true, std::memory_order_seq_cst);
+    }
+}
+
+void T_Thread::LeaveExclusive() {
+    exclusive_running.store(false, std::memory_order_seq_cst);
+    exclusive_running.notify_all();
+    exclusive_mutex.unlock();
 }
 
-bool T_Thread::is_any_thread_idle_or_paused()
-{
-    // Iterate through the thread pool and check the status of other threads' queues.
-    // If one thread has an empty queue and isn't paused, it's considered idle.
-    for (auto& thread : thread_pool) {
-        if (thread.get()->msgQ.empty()) {
-            return true;  // At least one thread is idle or paused, allow worker to steal
+void T_Thread::RunMessage(const Message& msg) {
+    if (msg.type == MessageType::Task && (msg.job || msg.task)) {
+        MessageType expected = MessageType::Pool;
+        state_.compare_exchange_strong(expected, MessageType::Run, std::memory_order_acq_rel);
+        bool exclusive = msg.Priority() == PriorityLevel::EXCLUSIVE;
+        if (exclusive) {
+            EnterExclusive();
+        }
+        else {
+            EnterShared();
+        }
+        TASK_TRACE_EVENT(Start, msg.TraceId());
+        int64_t start = MetricsNowNs();
+        if (msg.job) {
+            msg.job->Run();
+        }
+        else {
+            RunTask(msg.task);
+        }
+        int64_t end = MetricsNowNs();
+        TASK_TRACE_EVENT(End, msg.TraceId());
+        if (exclusive) {
+            LeaveExclusive();
+        }
+        else {
+            LeaveShared();
+        }
+
+        uint64_t ran = static_cast<uint64_t>(end - start);
+        WorkerCounters::Bump(counters_.executed);
+        WorkerCounters::Bump(counters_.busy_ns, ran);
+        WorkerCounters::Record(counters_.execution, ran);
+        if (msg.enqueued_ns != 0 && start > msg.enqueued_ns) {
+            WorkerCounters::Record(counters_.queue_wait, static_cast<uint64_t>(start - msg.enqueued_ns));
         }
+        expected = MessageType::Run;
+        state_.compare_exchange_strong(expected, MessageType::Pool, std::memory_order_acq_rel);
+    }
+    else if (msg.type == MessageType::Stop) {
+        state_.store(MessageType::Stop, std::memory_order_release);
     }
-    return false;
 }
+
 // Worker loop that listens for tasks and messages
 void T_Thread::Worker() {
+    current_ = this;
+    TASK_TRACE_THREAD_NAME("worker");
+    started_.wait(false, std::memory_order_acquire);
+
+    int spins = 0;
     while (true) {
-        std::shared_ptr<BaseTask> current_task;
+        MessageType state = state_.load(std::memory_order_acquire);
 
-        // Locking the queue for access
-        {
-            std::unique_lock<std::mutex> lock(queueMutex);
+        // If stop message is received, exit the loop
+        if (state == MessageType::Stop) break;
 
-            // Wait until there is a task or we need to stop
-            queueCV.wait(lock, [this]() {
-                return !msgQ.empty() || is_any_thread_idle_or_paused();
-                });
+        if (state == MessageType::Pause) {
+            // sleep on our own condition variable, pushes to task_signal do not wake a paused worker
+            std::unique_lock<std::mutex> lock(threadMutex);
+            pauseCV.wait(lock, [this] { return state_.load(std::memory_order_acquire) != MessageType::Pause; });
+            spins = 0;
+            continue;
+        }
 
-           
+        std::optional<Message> msg = FindWork();
+        if (msg) {
+            RunMessage(*msg);
+            spins = 0;
+            continue;
+        }
+        // spin briefly before parking, new work usually arrives in bursts
+        if (++spins < kSpinCount) {
+            std::this_thread::yield();
+            continue;
+        }
+        spins = 0;
 
-            if (message.type == MessageType::Pause) {
-                // Exit the worker loop or pause until resumed
-                continue;  // Skip to next iteration, effectively pausing
-            }
+        // park until something is pushed or the state changes
+        uint32_t key = task_signal.PrepareWait();
+        if (state_.load(std::memory_order_acquire) != state) {
+            task_signal.CancelWait();
+            continue;
+        }
+        msg = FindWork();  // a push may have raced PrepareWait
+        if (msg) {
+            task_signal.CancelWait();
+            RunMessage(*msg);
+            continue;
+        }
+        task_signal.Wait(key);
+    }
 
-            // If stop message is received, exit the loop
-            if (message.type == MessageType::Stop) break;
-
-            // Pop a task from the front of the queue
-            if (!msgQ.empty()) {
-                std::optional<Message> maybe = msgQ.pop();
-                if (maybe) {
-                    Message msg = *maybe;
-                    if (msg.type == MessageType::Task) {
-                        current_task = msg.task;
-                        current_task->Execute();
-                        current_task->SetCompleted();
-                    }
-                    else if (msg.type == MessageType::Stop) {
-                        message.type = MessageType::Stop;
-                        break;
-                    }
-                }
-            }
-            // Otherwise check the global task queue 
-            else if (!task_queue.empty()) {
-                std::optional<Message> maybe = task_queue.pop();
-                if (maybe) {
-                    Message msg = *maybe;
-                    if (msg.type == MessageType::Task) {
-                        current_task = msg.task;
-                        current_task->Execute();
-                        current_task->SetCompleted();
-                    }
-                    else if (msg.type == MessageType::Stop) {
-                        message.type = MessageType::Stop;
-                        break;
-                    }
-                }
-            }
-            else {  // Missing closing bracket for this 'else' block
-                // If the queue is empty, try stealing tasks from other threads
-                for (auto& thread : thread_pool) {
-                    // Ensure the weak pointer is still valid
-                      // Lock weak pointer
-                    if (!thread->msgQ.empty()) {
-                        std::optional<Message> maybe = thread->msgQ.pop();
-                        if (maybe) {
-                            Message msg = *maybe;
-                            if (msg.type == MessageType::Task) {
-                                current_task = msg.task;
-                                current_task->Execute();
-                                current_task->SetCompleted();
-                            }
-                            else if (msg.type == MessageType::Stop) {
-                                message.type = MessageType::Stop;
-                                break;
-                            }
-                            break; // Task stolen and processed, break from the stealing loop
-                        }
-                    }
-                }
-            }
-            if(task_queue.empty() && msgQ.empty())
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    // cancel anything left in the deques so its waiters return, a cancelled future may queue
+    // continuations here and those are cancelled by the same loop
+    for (auto& deque : deques_) {
+        while (PooledTask* left = deque.pop()) {
+            left->Cancel();
+            left->Release();
         }
     }
-}
\ No newline at end of file
+    TaskPool::FlushThreadCache();
+    current_ = nullptr;
+}
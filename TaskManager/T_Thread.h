@@ -1,46 +1,109 @@
 #pragma once
+#include <array>
+#include <atomic>
+#include <bit>
 #include "../Utilities/Logger.h"
 #include "MessageQueue.h"
+#include "WorkStealingDeque.h"
+#include "SchedulerMetrics.h"
+#include "SchedulerConfig.h"
+#include "DeadlineQueue.h"
 #include "Tasks.h"
 
 /// <T_Thread>
-/// T_Thread is an std::thread wrapper with a single Worker pool loop 
+/// T_Thread is an std::thread wrapper with a single Worker pool loop
 /// tthread is not an object since we want to use thread_ID rather than uuid
+/// each worker owns a Chase-Lev deque per priority level, the owner pushes/pops without a lock and
+/// idle workers steal from the other end, messages from other threads go through task_queue
+/// the deques hold pooled tasks, a shared_ptr task is wrapped in one when it is pushed
+/// work is taken from the highest priority bin found in the own deques, task_queue or a victim,
+/// every kAgingPeriod-th dispatch serves the bin that has waited longest so low priorities progress
+/// BLOCKED tasks only run when nothing else is queued, EXCLUSIVE tasks run with no other task running
+/// tasks in deadline_queue go before all of that, it is only filled in DispatchMode::EarliestDeadline
 /// </T_Thread>
 class T_Thread : public TaskQueue{
 public:
-    static std::vector<std::shared_ptr<T_Thread>> thread_pool;
-
-    // Constructor accepts a shared pointer to the message queue
+    // Constructor, the worker waits for Start before touching any queue
     T_Thread();
     // Non-movable
     T_Thread(const T_Thread& other) = delete;
     T_Thread& operator=(const T_Thread& other) = delete;
     // Destructor
     ~T_Thread();
-    // Set the task_
-    void set_task(std::shared_ptr<BaseTask> task_);
+    // pin the worker to cpus, call before Start so everything it allocates lands on that node
+    bool Pin(const std::vector<int>& cpus);
+    // hand the worker its steal victims and let it run
+    // victims are grouped into tiers ending at each tier_ends index, nearest tier first, all one tier if empty
+    void Start(const std::vector<T_Thread*>& victims, const std::vector<size_t>& tier_ends = {});
+    // queue a task on this worker
+    void set_task(std::shared_ptr<BaseTask> task);
     //set the message
     void SetMessage(Message msg);
     // Stop the thread
     void stop();
-    //pause the thread
+    // wait for the worker loop to exit
+    void join();
+    //push a message, lock free on the owning thread, otherwise posted to task_queue
     void pushMsg(const Message& messageIn);
+    //push a batch of tasks onto the owning worker's deque with one wakeup (owner thread only)
+    void pushTasks(std::span<const std::shared_ptr<BaseTask>> tasks);
+    //push a pooled task onto the owning worker's deque, no allocation and no lock (owner thread only)
+    void pushJob(TaskHandle job);
     // Get the thread's status
     Message GetMsg();
     //get the thread id
-    std::thread::id GetID() const; 
+    std::thread::id GetID() const;
+    //number of tasks waiting in this worker's deque
+    int64_t QueueDepth() const;
+    //the worker running on the calling thread, nullptr off the pool
+    static T_Thread* Current();
+    //fill in this worker's part of a metrics snapshot
+    void ReadMetrics(WorkerMetrics& out) const;
 private:
-    bool is_any_thread_idle_or_paused();
     // Worker loop that listens for tasks and messages
     void Worker();
-    MessageQueue msgQ;
+    // find the next task, highest priority bin first, see the class comment
+    std::optional<Message> FindWork();
+    // take one task from a priority bin, own deque, then task_queue, then steal
+    std::optional<Message> TakeFrom(size_t bin, bool oldest);
+    // push a pooled task onto the deque of its priority (owner thread only)
+    void PushLocal(PooledTask* job);
+    // the nonempty bin served longest ago, BLOCKED excluded
+    size_t LongestWaiting(uint32_t bins) const;
+    // wait until no EXCLUSIVE task runs and mark this worker active
+    void EnterShared();
+    // mark this worker inactive, wakes an EXCLUSIVE task waiting for it
+    void LeaveShared();
+    // take the pool for an EXCLUSIVE task, parks until every other worker has gone inactive
+    void EnterExclusive();
+    void LeaveExclusive();
+    // run a task message
+    void RunMessage(const Message& msg);
+    // wrap a BaseTask so it can go on the deque
+    static PooledTask* Wrap(std::shared_ptr<BaseTask> task);
+    // run a BaseTask, drop it through Cancel if its token was cancelled while it was queued,
+    // or set it aside in paused_tasks if it is paused
+    static void RunTask(const std::shared_ptr<BaseTask>& task);
+
+    static thread_local T_Thread* current_;  // worker bound to this thread
+    static constexpr int kSpinCount = 64;   // steal attempts before parking
+    static constexpr size_t kPriorityBins = static_cast<size_t>(PriorityLevel::BLOCKED) + 1;
+    static constexpr uint32_t kBlockedBit = 1u << static_cast<size_t>(PriorityLevel::BLOCKED);
+    static constexpr uint64_t kAgingPeriod = 16;  // dispatches between aged picks
+
+    std::array<WorkStealingDeque<PooledTask*>, kPriorityBins> deques_; // this worker's tasks by priority, each slot owns a reference
+    std::atomic<uint32_t> bin_mask_{ 0 };    // bins that may hold tasks, written by the owner only
+    alignas(64) std::atomic<bool> active_{ false }; // running a non EXCLUSIVE task
+    uint64_t dispatches_ = 0;                // tasks taken by this worker
+    std::array<uint64_t, kPriorityBins> served_{}; // dispatches_ when each bin was last served
+    std::vector<T_Thread*> victims_;         // workers to steal from, set once in Start
+    std::vector<size_t> tier_ends_;          // end of each victim tier in victims_
+    std::vector<size_t> next_victim_;        // round robin cursor per tier, worker only
+    std::atomic<bool> started_{ false };     // released by Start
+    std::atomic<MessageType> state_{ MessageType::Pool }; // Pool when idle, Run while executing
+    WorkerCounters counters_;                // written only by this worker
     std::mutex threadMutex;  // Mutex for locking
-    std::mutex queueMutex;
-    std::condition_variable queueCV;  // Condition variable to Notify the Worker thread
-    std::condition_variable pauseCV;  // Condition variable for pause
-    std::shared_ptr<BaseTask> task_;  // Task assigned to this thread
-    Message message;  // Thread status
+    std::condition_variable pauseCV;  // a paused worker sleeps here until SetMessage or stop
     std::thread t_thread;  // The actual thread
-    std::any result_;  //the last result 
+    std::any result_;  //the last result
 };
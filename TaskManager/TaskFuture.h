@@ -0,0 +1,169 @@
+#pragma once
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+#include "Tasks.h"
+
+class TaskScheduler;
+
+/// <FutureState>
+/// a task that keeps its own result, the task object is the shared state of its TaskFuture
+/// the result is stored inline so a small result costs no allocation beyond the task itself
+/// </FutureState>
+template <typename R>
+class FutureState : public BaseTask {
+public:
+    using value_type = std::conditional_t<std::is_void_v<R>, std::monostate, R>;
+
+    explicit FutureState(TaskScheduler* scheduler) : scheduler_(scheduler) {}
+    virtual ~FutureState() = default;
+
+    //return if the result or exception is available
+    bool IsReady() const { return ready_.load(std::memory_order_acquire) != 0; }
+    //block until the task_ has run
+    void Wait() const {
+        while (ready_.load(std::memory_order_acquire) == 0) {
+            ready_.wait(0, std::memory_order_acquire);
+        }
+    }
+    //the stored result, rethrows if the task_ threw (only valid once ready)
+    const value_type& Value() const {
+        if (error_) std::rethrow_exception(error_);
+        return *value_;
+    }
+    //run fn once the result is published, right away if it already is
+    void OnReady(std::function<void()> fn) {
+        {
+            std::lock_guard<std::mutex> lock(continuations_mutex_);
+            if (!IsReady()) {
+                continuations_.push_back(std::move(fn));
+                return;
+            }
+        }
+        fn();
+    }
+    //the scheduler continuations are submitted to
+    TaskScheduler* GetScheduler() const { return scheduler_; }
+    //drop the task_ unrun, the future reports TaskCancelled, a finished task_ keeps its result
+    virtual void Cancel() override {
+        if (IsReady()) return;
+        BaseTask::Cancel();
+        error_ = std::make_exception_ptr(TaskCancelled());
+        Publish();
+    }
+
+protected:
+    //invoke fn, keep its result or exception and wake everyone waiting on it
+    template <typename Fn>
+    void Run(Fn& fn) {
+        Store(fn);
+        Publish();
+    }
+    //invoke fn and keep its result or exception, nobody sees it before Publish
+    template <typename Fn>
+    void Store(Fn& fn) {
+        try {
+            if constexpr (std::is_void_v<R>) {
+                fn();
+                value_.emplace();
+            }
+            else {
+                value_.emplace(fn());
+            }
+        }
+        catch (...) {
+            error_ = std::current_exception();
+        }
+    }
+    //mark the result ready and run the continuations
+    void Publish() {
+        std::vector<std::function<void()>> ready_fns;
+        {
+            std::lock_guard<std::mutex> lock(continuations_mutex_);
+            ready_.store(1, std::memory_order_release);
+            ready_fns.swap(continuations_);
+        }
+        ready_.notify_all();
+        for (auto& ready_fn : ready_fns) {
+            ready_fn();
+        }
+    }
+
+private:
+    TaskScheduler* scheduler_;                          // where continuations go
+    std::optional<value_type> value_;                  // the result, inline
+    std::exception_ptr error_;                         // set instead of value_ if the task_ threw
+    std::atomic<uint32_t> ready_{ 0 };                 // 1 once value_ or error_ is set
+    std::mutex continuations_mutex_;
+    std::vector<std::function<void()>> continuations_; // guarded by continuations_mutex_
+};
+
+/// <FutureTask>
+/// binds the callable into the task object so make_shared gives one allocation for all of it
+/// </FutureTask>
+template <typename R, typename Fn>
+class FutureTask : public FutureState<R> {
+public:
+    FutureTask(TaskScheduler* scheduler, Fn fn)
+        : FutureState<R>(scheduler), fn_(std::move(fn)) {
+    }
+    virtual void Execute() override {
+        this->Run(fn_);
+    }
+private:
+    Fn fn_; //the callable with its bound arguments
+};
+
+/// <TaskFuture>
+/// handle to the result of a task_ submitted with TaskScheduler::Submit
+/// waiting on a worker thread ties that worker up, prefer then() there
+/// </TaskFuture>
+template <typename R>
+class TaskFuture {
+public:
+    using value_type = typename FutureState<R>::value_type;
+
+    TaskFuture() = default;
+    explicit TaskFuture(std::shared_ptr<FutureState<R>> state) : state_(std::move(state)) {}
+
+    //return if this future refers to a task_
+    bool valid() const { return state_ != nullptr; }
+    //return if the task_ has finished
+    bool is_ready() const { return state_->IsReady(); }
+    //block until the task_ has finished
+    void wait() const { state_->Wait(); }
+    //block and return the result, rethrows if the task_ threw
+    decltype(auto) get() const {
+        state_->Wait();
+        if constexpr (std::is_void_v<R>) {
+            state_->Value();
+        }
+        else {
+            return state_->Value();
+        }
+    }
+    //pointer to the result or nullptr while the task_ is still running, rethrows if it threw
+    const R* try_get() const requires (!std::is_void_v<R>) {
+        return state_->IsReady() ? &state_->Value() : nullptr;
+    }
+    bool try_get() const requires std::is_void_v<R> {
+        if (!state_->IsReady()) return false;
+        state_->Value();
+        return true;
+    }
+    //run fn with the result on a worker once it is ready, returns the future of fn
+    template <typename F>
+    auto then(F&& fn) const;
+    //the underlying task_
+    std::shared_ptr<BaseTask> task() const { return state_; }
+
+private:
+    std::shared_ptr<FutureState<R>> state_;
+};
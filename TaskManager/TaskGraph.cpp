@@ -0,0 +1,229 @@
+#include "TaskGraph.h"
+#include <algorithm>
+#include "TaskScheduler.h"
+
+TaskGraph::~TaskGraph() {
+    Wait();  // workers still hold pointers back into this graph
+}
+
+TaskGraph::NodeID TaskGraph::AddNode(std::shared_ptr<BaseTask> task_) {
+    NodeID id = nodes_.size();
+    Node& node = nodes_.emplace_back();
+    node.task_ = task_;
+    node.runner_ = std::make_shared<NodeTask>(this, id, remaining_);
+    dirty_ = true;
+    return id;
+}
+
+void TaskGraph::AddEdge(NodeID before, NodeID after) {
+    if (before >= nodes_.size() || after >= nodes_.size() || before == after) {
+        LOG_ERROR("Invalid task graph edge!");
+        return;
+    }
+    nodes_[before].successors_.push_back(after);
+    ++nodes_[after].predecessors_;
+    dirty_ = true;
+}
+
+void TaskGraph::Clear() {
+    Wait();
+    nodes_.clear();
+    order_.clear();
+    roots_.clear();
+    dirty_ = true;
+}
+
+bool TaskGraph::Submit(TaskScheduler& scheduler) {
+    if (!IsDone()) {
+        LOG_WARNING("Task graph submitted while still running.");
+        return false;
+    }
+    if (dirty_ && !Sort()) {
+        LOG_ERROR("Task graph has a cycle, not submitted!");
+        return false;
+    }
+    if (nodes_.empty()) {
+        return true;
+    }
+
+    // reset the counters, nothing is allocated on a resubmit
+    scheduler_ = &scheduler;
+    for (Node& node : nodes_) {
+        node.pending_.store(node.predecessors_, std::memory_order_relaxed);
+        node.skipped_.store(false, std::memory_order_relaxed);
+        node.runner_->SetPriority(node.task_->GetPriority());
+    }
+    remaining_->store(nodes_.size(), std::memory_order_release);
+
+    scheduler.AddTasks(roots_);
+    return true;
+}
+
+void TaskGraph::Wait() const {
+    size_t left = remaining_->load(std::memory_order_acquire);
+    while (left != 0) {
+        remaining_->wait(left, std::memory_order_acquire);
+        left = remaining_->load(std::memory_order_acquire);
+    }
+}
+
+bool TaskGraph::IsDone() const {
+    return remaining_->load(std::memory_order_acquire) == 0;
+}
+
+size_t TaskGraph::Size() const {
+    return nodes_.size();
+}
+
+void TaskGraph::NodeTask::Execute() {
+    Node& node = graph_->nodes_[id_];
+    if (node.task_->IsCancellationRequested()) {
+        Cancel();
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    // the successors and Finish must run whatever the task does, or Wait never returns
+    bool failed = false;
+    try {
+        node.task_->Execute();
+    }
+    catch (const std::exception& e) {
+        LOG_ERROR("Error executing task graph node {}: {}", id_, e.what());
+        failed = true;
+    }
+    catch (...) {
+        LOG_ERROR("Unknown error executing task graph node {}", id_);
+        failed = true;
+    }
+    if (!failed) {
+        node.task_->SetCompleted();
+    }
+    node.duration_ms_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    graph_->OnNodeDone(id_, failed);  // the dependents of a failed node are cancelled, not run on missing results
+    Finish();
+}
+
+void TaskGraph::NodeTask::Cancel() {
+    Skip();
+    graph_->OnNodeDone(id_, true);
+    Finish();
+}
+
+void TaskGraph::NodeTask::Skip() {
+    BaseTask::Cancel();
+    graph_->nodes_[id_].task_->Cancel();
+    graph_->nodes_[id_].duration_ms_ = 0.0;
+}
+
+void TaskGraph::NodeTask::Finish() {
+    // remaining_ is our own reference, nothing of the graph is touched once it may reach zero
+    if (remaining_->fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        remaining_->notify_all();
+    }
+}
+
+void TaskGraph::OnNodeDone(NodeID id, bool cancelled) {
+    // skipped nodes go on a worklist instead of recursing through their runner_, a long
+    // chain would take a few stack frames per node. id itself is finished by the caller, so
+    // remaining_ cannot reach zero in here
+    std::vector<NodeID> skipped;
+    NodeID done = id;
+    while (true) {
+        // release every successor whose last predecessor this was
+        for (NodeID next : nodes_[done].successors_) {
+            Node& node = nodes_[next];
+            if (cancelled) {
+                node.skipped_.store(true, std::memory_order_release);
+            }
+            if (node.pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                if (node.skipped_.load(std::memory_order_acquire)) {
+                    skipped.push_back(next);  // never queued, the scheduler may already be stopped
+                }
+                else {
+                    scheduler_->AddTask(node.runner_);  // on a worker this is a lock free deque push
+                }
+            }
+        }
+        if (done != id) {
+            nodes_[done].runner_->Finish();
+        }
+        if (skipped.empty()) {
+            return;
+        }
+        done = skipped.back();
+        skipped.pop_back();
+        nodes_[done].runner_->Skip();
+        cancelled = true;
+    }
+}
+
+bool TaskGraph::Sort() {
+    // Kahn's algorithm
+    std::vector<uint32_t> in_degree(nodes_.size());
+    order_.clear();
+    roots_.clear();
+    for (NodeID id = 0; id < nodes_.size(); ++id) {
+        in_degree[id] = nodes_[id].predecessors_;
+        if (in_degree[id] == 0) {
+            order_.push_back(id);
+            roots_.push_back(nodes_[id].runner_);
+        }
+    }
+    for (size_t i = 0; i < order_.size(); ++i) {
+        for (NodeID next : nodes_[order_[i]].successors_) {
+            if (--in_degree[next] == 0) {
+                order_.push_back(next);
+            }
+        }
+    }
+    if (order_.size() != nodes_.size()) {
+        return false;  // some nodes never reached zero, there is a cycle
+    }
+    dirty_ = false;
+    return true;
+}
+
+size_t TaskGraph::CriticalPathLength() {
+    if (dirty_ && !Sort()) {
+        return 0;
+    }
+    // longest chain ending at each node, counted in nodes
+    std::vector<size_t> depth(nodes_.size(), 1);
+    size_t longest = 0;
+    for (NodeID id : order_) {
+        for (NodeID next : nodes_[id].successors_) {
+            depth[next] = std::max(depth[next], depth[id] + 1);
+        }
+        longest = std::max(longest, depth[id]);
+    }
+    return longest;
+}
+
+double TaskGraph::CriticalPathTime() {
+    if (dirty_ && !Sort()) {
+        return 0.0;
+    }
+    // same walk as CriticalPathLength, weighted by the measured node times
+    std::vector<double> finish(nodes_.size(), 0.0);
+    double longest = 0.0;
+    for (NodeID id : order_) {
+        finish[id] += nodes_[id].duration_ms_;
+        for (NodeID next : nodes_[id].successors_) {
+            finish[next] = std::max(finish[next], finish[id]);
+        }
+        longest = std::max(longest, finish[id]);
+    }
+    return longest;
+}
+
+double TaskGraph::Parallelism() {
+    double critical = CriticalPathTime();
+    if (critical <= 0.0) {
+        return 0.0;
+    }
+    double total = 0.0;
+    for (const Node& node : nodes_) {
+        total += node.duration_ms_;
+    }
+    return total / critical;
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+#include "Tasks.h"
+
+class TaskScheduler;
+
+/// <TaskGraph>
+/// a dependency graph of tasks, a node is released to the workers as soon as its
+/// last predecessor finishes. build it once, then Submit it every frame, resubmitting
+/// only resets counters and does not allocate. the destructor waits for the current run
+/// a cancelled node, by StopAll or by its task's cancellation token, cancels every node
+/// that depends on it, so the run still finishes and Wait returns. a node whose task
+/// throws is logged and its dependents are cancelled the same way
+/// </TaskGraph>
+class TaskGraph {
+public:
+    using NodeID = size_t;
+
+    TaskGraph() = default;
+    TaskGraph(const TaskGraph& other) = delete;
+    TaskGraph& operator=(const TaskGraph& other) = delete;
+    ~TaskGraph();
+
+    //add a node, returns its id for AddEdge
+    NodeID AddNode(std::shared_ptr<BaseTask> task_);
+    //after runs only once before has finished
+    void AddEdge(NodeID before, NodeID after);
+    //remove every node and edge
+    void Clear();
+    //release the root nodes to the scheduler, false if a run is in flight or the graph has a cycle
+    bool Submit(TaskScheduler& scheduler);
+    //block until every node of the current run has finished
+    void Wait() const;
+    //return if the current run has finished
+    bool IsDone() const;
+    //number of nodes
+    size_t Size() const;
+    //number of nodes on the longest dependency chain
+    size_t CriticalPathLength();
+    //duration in ms of the longest chain, using the node times of the last run
+    double CriticalPathTime();
+    //total node time over critical path time of the last run, the speedup the graph allows
+    double Parallelism();
+
+private:
+    /// <NodeTask>
+    /// runs a node's task_ and releases its successors
+    /// </NodeTask>
+    class NodeTask : public BaseTask {
+    public:
+        NodeTask(TaskGraph* graph, NodeID id, std::shared_ptr<std::atomic<size_t>> remaining)
+            : graph_(graph), id_(id), remaining_(std::move(remaining)) {}
+        virtual void Execute() override;
+        //cancel the node's task_ and everything that depends on it
+        virtual void Cancel() override;
+        //cancel the node's task_ only, OnNodeDone takes care of the dependents
+        void Skip();
+        //count the node as finished, the graph may be gone once the last one is counted
+        void Finish();
+    private:
+
+        TaskGraph* graph_;
+        NodeID id_;
+        std::shared_ptr<std::atomic<size_t>> remaining_;  // the graph's counter, outlives the graph
+    };
+
+    struct Node {
+        std::shared_ptr<BaseTask> task_;          // the user's task
+        std::shared_ptr<NodeTask> runner_;        // wrapper handed to the scheduler, reused every run
+        std::vector<NodeID> successors_;          // nodes waiting on this one
+        uint32_t predecessors_ = 0;               // number of incoming edges
+        std::atomic<uint32_t> pending_{ 0 };      // predecessors still running this run
+        std::atomic<bool> skipped_{ false };      // a predecessor was cancelled this run
+        double duration_ms_ = 0.0;                // execution time in the last run
+    };
+
+    //called by a NodeTask once its task_ finished or was cancelled, releases or cancels the successors
+    void OnNodeDone(NodeID id, bool cancelled);
+    //rebuild the topological order after the graph changed, false on a cycle
+    bool Sort();
+
+    std::deque<Node> nodes_;                          // deque so nodes never move
+    std::vector<NodeID> order_;                       // topological order, valid while !dirty_
+    std::vector<std::shared_ptr<BaseTask>> roots_;    // runners of nodes without predecessors
+    bool dirty_ = true;                               // graph changed since the last Sort
+    TaskScheduler* scheduler_ = nullptr;              // scheduler of the current run
+    // nodes left in the current run, shared with the runners so the last one can still
+    // notify after Wait has returned and the graph is destroyed
+    std::shared_ptr<std::atomic<size_t>> remaining_ = std::make_shared<std::atomic<size_t>>(0);
+};
@@ -3,21 +3,27 @@
 // Define and initialize the static member
 std::shared_ptr<TaskScheduler> TaskManager::task_scheduler_ = nullptr;
 std::mutex TaskManager::mutex_;
+SchedulerConfig TaskManager::config_;
 
 // Get the singleton instance of TaskScheduler
 std::shared_ptr<TaskScheduler> TaskManager::Scheduler() {
     std::lock_guard<std::mutex> lock(mutex_);
     if (!task_scheduler_) 
-        task_scheduler_ = std::make_shared<TaskScheduler>();  // First-time initialization
+        task_scheduler_ = std::make_shared<TaskScheduler>(config_);  // First-time initialization
 
     return task_scheduler_;
 }
-//get threadmap
-std::shared_ptr<std::unordered_map<std::thread::id,std::shared_ptr<T_Thread>>> TaskManager::ThreadMap() {
+bool TaskManager::Configure(const SchedulerConfig& config) {
     std::lock_guard<std::mutex> lock(mutex_);
+    if (task_scheduler_) 
+        return false;
+    config_ = config;
+    return true;
+}
+//get threadmap, Scheduler() takes mutex_ itself and the scheduler is kept alive by the returned pointer
+std::shared_ptr<std::unordered_map<std::thread::id,std::shared_ptr<T_Thread>>> TaskManager::ThreadMap() {
     return Scheduler()->GetThreadMap();
 }
-std::shared_ptr<GameTimer> TaskManager::Clock() {
-    std::lock_guard<std::mutex> lock(mutex_);
+std::shared_ptr<HighResClock> TaskManager::Clock() {
     return Scheduler()->get_clock();
 }
@@ -1,5 +1,6 @@
 #pragma once
 #include "TaskScheduler.h"
+#include "Job.h"
 
 class TaskManager {
 public:
@@ -12,10 +13,13 @@ public:
 
     // Singleton accessor
     static std::shared_ptr<TaskScheduler> Scheduler();
-    static std::shared_ptr<GameTimer> Clock();
+    // set the pool config used when the singleton is first created, false if it already exists
+    static bool Configure(const SchedulerConfig& config);
+    static std::shared_ptr<HighResClock> Clock();
     static std::shared_ptr<std::unordered_map<std::thread::id, std::shared_ptr<T_Thread>>>  ThreadMap();
 private:
     static std::mutex mutex_;
+    static SchedulerConfig config_;  // used by the first Scheduler() call
     static std::shared_ptr<TaskScheduler> task_scheduler_;  // The singleton TaskScheduler instance
 };
 
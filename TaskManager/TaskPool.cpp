@@ -0,0 +1,100 @@
+#include "TaskPool.h"
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace {
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    // blocks shared between threads, touched only when a thread cache runs dry or overflows
+    struct SharedList {
+        std::mutex mtx;
+        FreeBlock* head = nullptr;
+        size_t count = 0;
+    };
+
+    // leaked on purpose, tasks still in flight during static destruction may free into it
+    SharedList& Shared() {
+        static SharedList* shared = new SharedList();
+        return *shared;
+    }
+
+    // trivially destructible so a late free on an exiting thread stays valid
+    struct ThreadCache {
+        FreeBlock* head;
+        size_t count;
+    };
+    thread_local ThreadCache cache{ nullptr, 0 };
+
+    // move up to n blocks from the front of the thread cache to the shared list
+    void Spill(size_t n) {
+        if (n == 0 || cache.head == nullptr) return;
+        FreeBlock* first = cache.head;
+        FreeBlock* last = first;
+        size_t moved = 1;
+        while (moved < n && last->next != nullptr) {
+            last = last->next;
+            ++moved;
+        }
+        cache.head = last->next;
+        cache.count -= moved;
+
+        SharedList& shared = Shared();
+        std::lock_guard<std::mutex> lock(shared.mtx);
+        last->next = shared.head;
+        shared.head = first;
+        shared.count += moved;
+    }
+
+    // refill an empty thread cache from the shared list, or carve a new slab
+    void Refill() {
+        SharedList& shared = Shared();
+        {
+            std::lock_guard<std::mutex> lock(shared.mtx);
+            while (shared.head != nullptr && cache.count < TaskPool::kSlabBlocks) {
+                FreeBlock* block = shared.head;
+                shared.head = block->next;
+                --shared.count;
+                block->next = cache.head;
+                cache.head = block;
+                ++cache.count;
+            }
+        }
+        if (cache.head != nullptr) return;
+
+        std::byte* slab = static_cast<std::byte*>(
+            ::operator new(TaskPool::kBlockSize * TaskPool::kSlabBlocks, std::align_val_t{ TaskPool::kBlockSize }));
+        for (size_t i = TaskPool::kSlabBlocks; i-- > 0;) {
+            FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + i * TaskPool::kBlockSize);
+            block->next = cache.head;
+            cache.head = block;
+        }
+        cache.count = TaskPool::kSlabBlocks;
+    }
+}
+
+void* TaskPool::Allocate() {
+    if (cache.head == nullptr) {
+        Refill();
+    }
+    FreeBlock* block = cache.head;
+    cache.head = block->next;
+    --cache.count;
+    return block;
+}
+
+void TaskPool::Free(void* block) {
+    if (block == nullptr) return;
+    FreeBlock* freed = static_cast<FreeBlock*>(block);
+    freed->next = cache.head;
+    cache.head = freed;
+    if (++cache.count > kCacheLimit) {
+        Spill(kCacheLimit / 2);  // a consumer thread, keep the producers supplied
+    }
+}
+
+void TaskPool::FlushThreadCache() {
+    Spill(cache.count);
+}
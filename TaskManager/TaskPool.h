@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+
+/// <TaskPool>
+/// slab allocator for pooled task objects, every block is one cache line sized TaskPool::kBlockSize
+/// each thread keeps its own free list so allocating and freeing on a worker never takes a lock,
+/// a thread that frees more than it allocates hands blocks back to a shared list in batches
+/// slabs are never returned to the system, the pool grows to the peak number of live tasks
+/// </TaskPool>
+class TaskPool {
+public:
+    static constexpr size_t kBlockSize = 64;    // bytes per block, callers must fit in it
+    static constexpr size_t kSlabBlocks = 64;   // blocks carved from each new slab
+    static constexpr size_t kCacheLimit = 256;  // blocks a thread keeps before handing half back
+
+    TaskPool() = delete;
+
+    // take a block, from the calling thread's free list when it has one
+    static void* Allocate();
+    // give a block back to the calling thread's free list
+    static void Free(void* block);
+    // hand the calling thread's cached blocks to the shared list, call before a thread exits
+    static void FlushThreadCache();
+};
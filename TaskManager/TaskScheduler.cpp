@@ -1,13 +1,66 @@
 #include "TaskScheduler.h"
+#include "DeadlineQueue.h"
 
-TaskScheduler::TaskScheduler() {
-    clock_ = std::make_shared<GameTimer>();
-    priority_bins_.resize(static_cast<size_t>(PriorityLevel::BLOCKED)+1);
-
-    // Create threads with the shared message queue
-    for (size_t i = 0; i < std::thread::hardware_concurrency() - 1; ++i) {  // num_threads-1? This seems odd, unless there's a reason
+TaskScheduler::TaskScheduler(const SchedulerConfig& config) {
+    if (config.tsc_clock && !HighResClock::EnableTsc()) {
+        LOG_INFO("No invariant TSC, the scheduler clock stays on the monotonic clock");
+    }
+    clock_ = std::make_shared<HighResClock>();  // running from here, ScheduleTask can read it
+    edf_ = config.dispatch == DispatchMode::EarliestDeadline;
+    miss_policy_ = config.miss_policy;
+
+    // Create threads with the shared message queue, pinned before they touch any memory
+    std::vector<NumaNode> nodes;
+    if (config.numa_aware) {
+        nodes = CpuTopology::Nodes();
+    }
+    std::vector<T_Thread*> workers;
+    std::vector<int> worker_node;
+    size_t count = config.ResolveWorkers();
+    for (size_t i = 0; i < count; ++i) {
         std::shared_ptr<T_Thread> new_thread = std::make_shared<T_Thread>();
+        int node = -1;
+        if (i < config.affinity.size() && !config.affinity[i].empty()) {
+            if (!new_thread->Pin(config.affinity[i])) {
+                LOG_WARNING("could not pin worker {} to its cpus, it runs unpinned", i);
+            }
+            node = CpuTopology::NodeOf(nodes, config.affinity[i].front());
+        }
         thread_pool_.insert({ new_thread->GetID(), new_thread });
+        workers.push_back(new_thread.get());
+        worker_node.push_back(node);
+    }
+
+    // every worker may steal from every other worker, with numa_aware the ones on its own node
+    // come first and the rest follow by node distance, unpinned workers count as farthest
+    for (size_t i = 0; i < workers.size(); ++i) {
+        std::vector<size_t> order;
+        for (size_t j = 0; j < workers.size(); ++j) {
+            if (j != i) order.push_back(j);
+        }
+        if (config.numa_aware && worker_node[i] >= 0) {
+            auto distance = [&](size_t j) {
+                int to = worker_node[j];
+                if (to < 0) return INT_MAX;
+                if (to == worker_node[i]) return 0;
+                for (const NumaNode& node : nodes) {
+                    if (node.id == worker_node[i] && to < static_cast<int>(node.distance.size())) {
+                        return node.distance[to];
+                    }
+                }
+                return INT_MAX - 1;
+            };
+            std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return distance(a) < distance(b); });
+        }
+        std::vector<T_Thread*> victims;
+        std::vector<size_t> tier_ends;
+        for (size_t k = 0; k < order.size(); ++k) {
+            if (config.numa_aware && worker_node[i] >= 0 && k > 0 && worker_node[order[k]] != worker_node[order[k - 1]]) {
+                tier_ends.push_back(k);
+            }
+            victims.push_back(workers[order[k]]);
+        }
+        workers[i]->Start(victims, tier_ends);
     }
 
     workerThread = std::thread(&TaskScheduler::Worker, this);
@@ -20,87 +73,367 @@ TaskScheduler::~TaskScheduler() {
 }
 
 void TaskScheduler::AddTask(std::shared_ptr<BaseTask> task_) {
+    if (edf_ && task_->HasDeadline()) {
+        TASK_TRACE_EVENT(Enqueue, reinterpret_cast<uintptr_t>(task_.get()));
+        deadline_queue.push(task_, miss_policy_);
+        task_signal.NotifyOne();
+        return;
+    }
+
+    // a worker submitting work pushes onto its own deque, no lock and no dispatcher hop
+    if (T_Thread* worker = T_Thread::Current()) {
+        worker->pushMsg(Message{ MessageType::Task, task_ });
+        return;
+    }
+
     size_t bin_index = static_cast<size_t>(task_->GetPriority());
-    if (bin_index < priority_bins_.size()) {
-        std::lock_guard<std::mutex> lock(binsMutex);  // Lock only when adding tasks to the queue
-        priority_bins_[bin_index].push(task_); // Add task_ to the bin
-        Logger::Get()->LogInfo(Log_Level::Info, "Task added to bin: "); 
-        cv.notify_one();  // Notify the Worker thread to check for new tasks
+    if (bin_index <= static_cast<size_t>(PriorityLevel::BLOCKED)) {
+        TASK_TRACE_EVENT(Enqueue, reinterpret_cast<uintptr_t>(task_.get()));
+        task_queue.push(Message{ MessageType::Task, task_ }); // Add task_ to its priority bin
+        task_signal.NotifyOne();  // wake a parked worker directly, the dispatcher is not involved
+        LOG_DEBUG("Task added to bin: {}", bin_index);
     }
     else {
-        Logger::Get()->LogInfo(Log_Level::Error, "Invalid priority level!");
+        LOG_ERROR("Invalid priority level!");
     }
 };
 
-void TaskScheduler::ScheduleTask(std::shared_ptr<BaseTask> task_, float interval) {
-    std::string id = task_->GetID();
-    Periodic_Task pt(task_, interval,get_clock());
+void TaskScheduler::AddTasks(std::span<const std::shared_ptr<BaseTask>> tasks) {
+    if (tasks.empty()) return;
+
+    if (edf_ && std::any_of(tasks.begin(), tasks.end(), [](const auto& task) { return task && task->HasDeadline(); })) {
+        // deadline tasks go one by one to the deadline queue, the rest stay a batch
+        std::vector<std::shared_ptr<BaseTask>> rest;
+        for (const auto& task : tasks) {
+            if (task && task->HasDeadline()) {
+                AddTask(task);
+            }
+            else {
+                rest.push_back(task);
+            }
+        }
+        AddTasks(std::span<const std::shared_ptr<BaseTask>>(rest));
+        return;
+    }
+
+    // from a worker the whole batch goes onto its own deque
+    if (T_Thread* worker = T_Thread::Current()) {
+        worker->pushTasks(tasks);
+        return;
+    }
+
+#if TASK_TRACE
+    for (const auto& task : tasks) {
+        if (task) TASK_TRACE_EVENT(Enqueue, reinterpret_cast<uintptr_t>(task.get()));
+    }
+#endif
+    size_t queued = task_queue.push_tasks(tasks);  // one lock for the whole batch
+    task_signal.Notify(static_cast<uint32_t>(std::min<size_t>(queued, UINT32_MAX)));  // wake as many idle workers as there are tasks
+    if (queued != tasks.size()) {
+        LOG_ERROR("Invalid priority level in batch, {} tasks dropped!", tasks.size() - queued);
+    }
+    LOG_DEBUG("Task batch added to bins: {}", queued);
+}
+
+void TaskScheduler::AddTasks(std::span<const std::function<void()>> task_fns) {
+    std::vector<std::shared_ptr<BaseTask>> tasks;
+    tasks.reserve(task_fns.size());
+    for (const auto& task_fn : task_fns) {
+        tasks.push_back(std::make_shared<Task>(task_fn));
+    }
+    AddTasks(std::span<const std::shared_ptr<BaseTask>>(tasks));
+}
+
+void TaskScheduler::ScheduleTask(std::shared_ptr<BaseTask> task_, float interval_ms, PeriodicPolicy policy, uint32_t max_catch_up) {
+    ScheduleTask(std::move(task_), std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::duration<double, std::milli>(interval_ms)), policy, max_catch_up);
+}
+
+void TaskScheduler::ScheduleTask(std::shared_ptr<BaseTask> task_, std::chrono::nanoseconds interval, PeriodicPolicy policy, uint32_t max_catch_up) {
+    EntityID id = task_->GetID();
+    auto runner = std::make_shared<PeriodicRun>(this, id, task_);
+    runner->SetPriority(task_->GetPriority());
+    CancellationSource cancel;
+    runner->SetCancellationToken(cancel.Token());
+    {
+        std::lock_guard<std::mutex> lock(scheduledTasksMutex);
+        Periodic_Task& pt = scheduled_tasks_[id];
+        pt.cancel.Cancel();  // drop a queued run of the entry this replaces
+        pt = Periodic_Task(task_, interval.count(), get_clock());
+        pt.cancel = cancel;
+        pt.policy = policy;
+        pt.maxCatchUp = policy == PeriodicPolicy::FixedRate ? max_catch_up : 0;
+        pt.runner = runner;  // a run of a replaced entry reports a different runner and is ignored
+        ArmTimer(id, pt);
+    }
+    cv.notify_one();  // the dispatcher may be sleeping on a later deadline
+}
+
+void TaskScheduler::RunAfter(std::chrono::nanoseconds delay, std::function<void()> fn) {
     {
         std::lock_guard<std::mutex> lock(scheduledTasksMutex);
-        scheduled_tasks_[id] = pt;
+        if (stopFlag) return;
+        int64_t deadline = clock_->ElapsedNs() + delay.count();
+        uint64_t seq = ++timer_seq_;
+        // a std::function does not fit the inline buffer of a pooled job on every standard library
+        one_shot_timers_.emplace(seq, OneShotTimer{ deadline, std::make_shared<Task>(std::move(fn)) });
+        timer_heap_.push(TimerEntry{ deadline, seq, EntityID{} });
+    }
+    cv.notify_one();
+}
+
+TaskScheduler::ScheduleAwaiter TaskScheduler::Schedule(PriorityLevel priority) {
+    return ScheduleAwaiter{ priority };
+}
+
+TaskScheduler::DelayAwaiter TaskScheduler::Delay(std::chrono::nanoseconds delay) {
+    return DelayAwaiter{ this, delay };
+}
+
+void TaskScheduler::ScheduleAwaiter::await_suspend(std::coroutine_handle<> handle) const {
+    ResumeOnPool(handle, priority);
+}
+
+void TaskScheduler::DelayAwaiter::await_suspend(std::coroutine_handle<> handle) const {
+    scheduler->RunAfter(delay, [handle]() { handle.resume(); });
+}
+
+size_t TaskScheduler::DrainMainThread(std::chrono::nanoseconds budget) {
+    int64_t end = HighResClock::Now() + budget.count();
+    size_t ran = 0;
+    do {
+        std::shared_ptr<BaseTask> task_;
+        {
+            std::lock_guard<std::mutex> lock(main_mutex_);
+            if (main_tasks_.empty()) break;
+            task_ = std::move(main_tasks_.front());
+            main_tasks_.pop_front();
+        }
+        if (task_->IsCancellationRequested()) {
+            task_->Cancel();
+        }
+        else {
+            task_->Execute();
+            task_->SetCompleted();
+        }
+        ++ran;
+    } while (HighResClock::Now() < end);
+    return ran;
+}
+
+void TaskScheduler::ResumeOnPool(std::coroutine_handle<> handle, PriorityLevel priority) {
+    PushJob(TaskHandle::Adopt(PooledTask::Create([handle]() { handle.resume(); }, priority)));
+}
+
+void TaskScheduler::PushJob(TaskHandle job) {
+    if (T_Thread* worker = T_Thread::Current()) {
+        worker->pushJob(std::move(job));
+    }
+    else {
+        TASK_TRACE_EVENT(Enqueue, reinterpret_cast<uintptr_t>(job.get()));
+        task_queue.push(Message{ MessageType::Task, nullptr, {}, nullptr, std::move(job) });
+        task_signal.NotifyOne();
     }
 }
 
 void TaskScheduler::StopAll() {
-    stopFlag = true;
+    {
+        std::lock_guard<std::mutex> lock(scheduledTasksMutex);
+        stopFlag = true;
+    }
     cv.notify_all();
 
     // Stop Worker threads first
     for (auto& thread : thread_pool_) {
         thread.second->stop();
     }
+    // join them all before any is destroyed, a worker may still be stealing from another
+    for (auto& thread : thread_pool_) {
+        thread.second->join();
+    }
+    if (workerThread.joinable()) {
+        workerThread.join();  // nothing queues periodic runs anymore
+    }
 
+    // every task that will not run now is cancelled, so a future or a graph waiting on it returns
+    std::vector<std::shared_ptr<BaseTask>> dropped;
     {
-        // Lock and drain the task_ queues instead of clearing containers
-        std::lock_guard<std::mutex> lock(binsMutex);
-
-        for (auto& bin : priority_bins_) {
-            std::queue<std::shared_ptr<BaseTask>> empty;
-            std::swap(bin, empty);  // clears bin without invalidating vector
+        std::lock_guard<std::mutex> lock(scheduledTasksMutex);
+        for (auto& entry : scheduled_tasks_) {
+            dropped.push_back(entry.second.task_);
+        }
+        for (auto& entry : one_shot_timers_) {
+            dropped.push_back(entry.second.task);
         }
-
         scheduled_tasks_.clear();  // okay to clear now that stop_flag is set
+        one_shot_timers_.clear();
+        timer_heap_ = {};
     }
-
-    if (workerThread.joinable()) {
-        workerThread.join();  // now it's safe to wait for the Worker
+    {
+        std::lock_guard<std::mutex> paused_lock(paused_mutex);
+        for (auto& entry : paused_tasks) {
+            dropped.push_back(entry.second);
+        }
+        paused_tasks.clear();
+    }
+    {
+        // nobody may be left to call DrainMainThread
+        std::lock_guard<std::mutex> main_lock(main_mutex_);
+        main_closed_ = true;
+        for (auto& task_ : main_tasks_) {
+            dropped.push_back(task_);
+        }
+        main_tasks_.clear();
+    }
+    // cancel outside the locks, the continuations of a cancelled future may queue more tasks
+    // and those are drained and cancelled on the next pass
+    while (true) {
+        for (auto& task : dropped) {
+            task->Cancel();
+        }
+        std::vector<Message> queued = task_queue.drain();
+        dropped = deadline_queue.drain();
+        if (queued.empty() && dropped.empty()) break;
+        for (Message& msg : queued) {
+            if (msg.job) {
+                msg.job->Cancel();
+            }
+            else if (msg.task) {
+                dropped.push_back(std::move(msg.task));
+            }
+        }
     }
 
     // Now safe to clear containers
     thread_pool_.clear();
-    priority_bins_.clear();  // container itself can be destroyed
-    Logger::Get()->LogInfo(Log_Level::Info, "All tasks and threads have been cleared.");
+    LOG_INFO("All tasks and threads have been cleared.");
 }
 
-std::shared_ptr<GameTimer> TaskScheduler::get_clock() {
+std::shared_ptr<HighResClock> TaskScheduler::get_clock() {
     return clock_;
 };
+std::chrono::steady_clock::time_point TaskScheduler::DeadlineAt(std::chrono::nanoseconds elapsed) const {
+    // clock_ is on the steady_clock timeline and never stopped
+    return std::chrono::steady_clock::time_point(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::nanoseconds(clock_->OriginNs()) + elapsed));
+}
 //stop a task_
-void TaskScheduler::StopTask(const std::string& id) {
+void TaskScheduler::StopTask(EntityID id) {
     std::lock_guard<std::mutex> lock(scheduledTasksMutex);
-    scheduled_tasks_.erase(id);
+    auto it = scheduled_tasks_.find(id);
+    if (it == scheduled_tasks_.end()) return;
+    it->second.cancel.Cancel();  // a run already queued is dropped when dequeued
+    scheduled_tasks_.erase(it);  // its heap entry goes stale and is dropped when it surfaces
+    CompactTimers();
 }
 //pause a task_
-void TaskScheduler::PauseTask(std::string id) {
+void TaskScheduler::PauseTask(EntityID id) {
     std::lock_guard<std::mutex> lock(scheduledTasksMutex);
     auto it = scheduled_tasks_.find(id);
     if (it != scheduled_tasks_.end()) {
         it->second.task_->PauseTask();
     }
     else {
-        Logger::Get()->LogInfo(Log_Level::Warning, "Pause failed: task not found with id: " + id);
+        LOG_WARNING("Pause failed: task not found with id: {:016x}", id.value);
     }
 }
 
-void TaskScheduler::ResumeTask(std::string id) {
-    std::lock_guard<std::mutex> lock(scheduledTasksMutex);
-    auto it = scheduled_tasks_.find(id);
-    if (it != scheduled_tasks_.end()) {
-        it->second.task_->ResumeTask();
+void TaskScheduler::PauseTask(const std::shared_ptr<BaseTask>& task_) {
+    task_->PauseTask();  // periodic or not, the flag is all that is needed
+}
+
+void TaskScheduler::ResumeTask(EntityID id) {
+    {
+        std::lock_guard<std::mutex> lock(scheduledTasksMutex);
+        auto it = scheduled_tasks_.find(id);
+        if (it != scheduled_tasks_.end()) {
+            it->second.task_->ResumeTask();
+            if (it->second.parked) {
+                // rearm from now rather than firing every missed run at once
+                it->second.parked = false;
+                it->second.nextExecutionTime = clock_->ElapsedNs();
+                ArmTimer(id, it->second);
+                cv.notify_one();
+            }
+            return;
+        }
+    }
+    if (!Unpark(id)) {
+        LOG_WARNING("Resume failed: task not found with id: {:016x}", id.value);
+    }
+}
+
+void TaskScheduler::ResumeTask(const std::shared_ptr<BaseTask>& task_) {
+    // clear the flag first, a task still queued then simply runs when it is dequeued
+    task_->ResumeTask();
+    bool periodic;
+    {
+        std::lock_guard<std::mutex> lock(scheduledTasksMutex);
+        periodic = scheduled_tasks_.count(task_->GetID()) != 0;
+    }
+    if (periodic) {
+        ResumeTask(task_->GetID());  // re-arms it
     }
     else {
-        Logger::Get()->LogInfo(Log_Level::Warning, "Resume failed: task not found with id: " + id);
+        Unpark(task_->GetID());
+    }
+}
+
+bool TaskScheduler::Unpark(EntityID id) {
+    std::shared_ptr<BaseTask> task_;
+    {
+        std::lock_guard<std::mutex> lock(paused_mutex);
+        auto it = paused_tasks.find(id);
+        if (it == paused_tasks.end()) {
+            return false;
+        }
+        task_ = std::move(it->second);
+        paused_tasks.erase(it);
+    }
+    task_->ResumeTask();
+    AddTask(task_);  // its priority is untouched, it goes back to its own bin
+    return true;
+}
+
+void TaskScheduler::PauseAll() {
+    {
+        std::lock_guard<std::mutex> lock(scheduledTasksMutex);
+        if (paused_ || stopFlag) return;
+        paused_ = true;
+        pausedAt_ = clock_->ElapsedNs();
+    }
+    cv.notify_one();  // the dispatcher drops its timed wait
+    PostMessage(Message{ MessageType::Pause });
+    LOG_INFO("Scheduler paused.");
+}
+
+void TaskScheduler::ResumeAll() {
+    {
+        std::lock_guard<std::mutex> lock(scheduledTasksMutex);
+        if (!paused_) return;
+        paused_ = false;
+        int64_t paused_for = clock_->ElapsedNs() - pausedAt_;
+        for (auto& [id, pt] : scheduled_tasks_) {
+            pt.nextExecutionTime += paused_for;
+            // parked ones re-arm on ResumeTask, a FixedDelay run in flight re-arms when it completes
+            if (!pt.parked && !(pt.policy == PeriodicPolicy::FixedDelay && pt.inFlight)) {
+                ArmTimer(id, pt);
+            }
+        }
+        std::unordered_map<uint64_t, OneShotTimer> shifted;
+        for (auto& [seq, timer] : one_shot_timers_) {
+            // the old heap entry goes stale under the new sequence
+            OneShotTimer moved{ timer.deadline + paused_for, std::move(timer.task) };
+            uint64_t next = ++timer_seq_;
+            timer_heap_.push(TimerEntry{ moved.deadline, next, EntityID{} });
+            shifted.emplace(next, std::move(moved));
+        }
+        one_shot_timers_.swap(shifted);
+        CompactTimers();
     }
+    cv.notify_one();
+    PostMessage(Message{ MessageType::Pool });
+    LOG_INFO("Scheduler resumed.");
 }
 
 std::shared_ptr<std::unordered_map<std::thread::id, std::shared_ptr<T_Thread>>> TaskScheduler::GetThreadMap() {
@@ -112,123 +445,189 @@ void TaskScheduler::PostMessage(const Message& msg) {
     }
 }
 void TaskScheduler::Worker() {
-    clock_->Start();  // Start the clock before entering the loop
+    // regular tasks go straight from AddTask to the workers, this loop only runs timed work
+    TASK_TRACE_THREAD_NAME("dispatcher");
+    std::unique_lock<std::mutex> lock(scheduledTasksMutex);
+    while (!stopFlag) {
+        if (paused_) {
+            cv.wait(lock, [this] { return !paused_ || stopFlag; });
+            continue;
+        }
+        HandlePeriodicTasks();
 
-    while (true) {
-        std::shared_ptr<BaseTask> current_task = nullptr;
+        // sleep until the next periodic task_ is due, ScheduleTask/ResumeTask/StopAll wake us early
+        std::optional<int64_t> wait_ns = TimeUntilNextRun();
+        if (wait_ns) {
+            cv.wait_for(lock, std::chrono::nanoseconds(*wait_ns));
+        }
+        else {
+            cv.wait(lock);
+        }
+    }
+    // Optionally LogInfo when the Worker is stopping
+    LOG_INFO("Worker thread exiting.");
+}
 
-        {
-            std::unique_lock<std::mutex> lock(binsMutex);
+//handle periodic tasks
+void TaskScheduler::HandlePeriodicTasks() {
+    int64_t current_time = clock_->ElapsedNs();
+
+    // only the due timers are touched, the rest stay in the heap
+    while (!timer_heap_.empty() && timer_heap_.top().deadline <= current_time) {
+        TimerEntry entry = timer_heap_.top();
+        timer_heap_.pop();
+
+        auto shot = one_shot_timers_.find(entry.seq);
+        if (shot != one_shot_timers_.end()) {
+            AddTask(std::move(shot->second.task));
+            one_shot_timers_.erase(shot);
+            continue;
+        }
 
-            // Wait for a signal indicating either a new task_ or stop
-            cv.wait(lock, [this]() {
-                return stopFlag || !AllQueuesEmpty() || !scheduled_tasks_.empty();
-                });
+        auto it = scheduled_tasks_.find(entry.id);
+        if (it == scheduled_tasks_.end() || it->second.timerSeq != entry.seq) {
+            continue;  // stopped or rescheduled since this entry was pushed
+        }
+        Periodic_Task& pt = it->second;
 
-            // If stop flag is set and there are no tasks to process, exit the loop
-            if (stopFlag && AllQueuesEmpty() && scheduled_tasks_.empty()) {
-                break;
-            }
+        if (pt.task_->IsPaused()) {
+            LOG_DEBUG("Parking paused task: {:016x}", entry.id.value);
+            pt.parked = true;  // ResumeTask puts it back in the heap
+            continue;
+        }
 
-            // Process regular tasks if available
-            if (!AllQueuesEmpty()) {
-                HandleRegularTasks();
-            }
+        // whole intervals the dispatcher is behind on top of this tick
+        uint32_t missed = 0;
+        if (pt.interval > 0 && current_time > pt.Deadline()) {
+            missed = static_cast<uint32_t>(std::min<int64_t>((current_time - pt.Deadline()) / pt.interval, UINT32_MAX - 1));
+        }
 
-            // Process periodic tasks if available
-            if (!scheduled_tasks_.empty()) {
-                HandlePeriodicTasks();
-            }
-        } // Lock released here, the Worker can now process tasks
+        if (pt.inFlight) {
+            // the last run is still queued or executing, never queue a second one
+            missed += 1;
+        }
+        else {
+            DispatchPeriodic(pt);
+        }
 
-        // If there are no tasks to process and we're not stopping, sleep for a while
-        if (AllQueuesEmpty() && scheduled_tasks_.empty()) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));  // Prevent busy-waiting
+        if (pt.policy == PeriodicPolicy::FixedDelay) {
+            continue;  // re-armed by OnPeriodicDone once the run completes
         }
+
+        // stay on the original grid, skipping past every missed slot
+        pt.nextExecutionTime += pt.interval * (static_cast<int64_t>(missed) + 1);
+        pt.owedRuns = std::min(pt.maxCatchUp, pt.owedRuns + missed);
+        ArmTimer(entry.id, pt);
     }
-    // Optionally LogInfo when the Worker is stopping
-    Logger::Get()->LogInfo(Log_Level::Info, "Worker thread exiting.");
 }
 
-bool TaskScheduler::AllQueuesEmpty() {
-    for (const auto& bin : priority_bins_) {
-        if (!bin.empty()) return false;
-    }
-    return true;
-};
+void TaskScheduler::DispatchPeriodic(Periodic_Task& pt) {
+    pt.inFlight = true;
+    Message task_message{ MessageType::Task, pt.runner };  // Package the task in a Message
+    // the dispatcher owns no deque, queue it the way PushJob does from outside the pool
+    TASK_TRACE_EVENT(Enqueue, task_message.TraceId());
+    task_queue.push(task_message);
+    task_signal.NotifyOne();
+}
 
-//handle regulat tasks
-void TaskScheduler::HandleRegularTasks() {
-    for (auto& thread : thread_pool_) {
-        if (thread.second->GetMsg().type == MessageType::Pool) {
-            // Loop through the priority bins and assign tasks from the bins
-            std::shared_ptr<BaseTask> task_ = nullptr;
-            for (auto& bin : priority_bins_) {
-                if (!bin.empty()) {
-                    task_ = bin.front();
-                    bin.pop();  // Remove the task from the bin
-                    Message task_message{ MessageType::Task, std::shared_ptr<BaseTask>(task_) };  // Package the task in a Message
-
-                    // Add the task to the thread's message queue
-                    thread.second->pushMsg(task_message);  // Push the task message to the thread's queue
-                    Logger::Get()->LogInfo(Log_Level::Info, "Enqueuing task to thread.");
-                    return;  // Stop once a task is added to the queue
-                }
-            }
-        }
+void TaskScheduler::OnPeriodicDone(EntityID id, const BaseTask* runner) {
+    std::lock_guard<std::mutex> lock(scheduledTasksMutex);
+    auto it = scheduled_tasks_.find(id);
+    if (it == scheduled_tasks_.end() || it->second.runner.get() != runner) {
+        return;  // stopped or rescheduled while it ran
     }
-    //if we got this far add any tasks to the global queue until threads available
+    Periodic_Task& pt = it->second;
+    pt.inFlight = false;
 
-    std::shared_ptr<BaseTask> task_ = nullptr;
-    for (auto& bin : priority_bins_) {
-        if (!bin.empty()) {
-            task_ = bin.front();
-            bin.pop();  // Remove the task from the bin
-            Message task_message{ MessageType::Task, std::shared_ptr<BaseTask>(task_)};  // Package the task in a Message
-
-            // Add the task to the global saved message queue
-            task_queue.push(task_message);  // Push the task message to the thread's queue
-            Logger::Get()->LogInfo(Log_Level::Info, "Enqueuing task to thread.");
-            return;  // Stop once a task is added to the queue
+    if (pt.policy == PeriodicPolicy::FixedDelay) {
+        if (pt.task_->IsPaused()) {
+            pt.parked = true;
+            return;
         }
+        pt.nextExecutionTime = clock_->ElapsedNs();  // measure the delay from completion
+        ArmTimer(id, pt);
+        cv.notify_one();  // the dispatcher may be waiting on a later deadline or none
+    }
+    else if (pt.owedRuns > 0 && !pt.task_->IsPaused()) {
+        // fixed rate and behind, make up one missed run right away
+        --pt.owedRuns;
+        DispatchPeriodic(pt);
     }
 }
-//handle periodic tasks
-void TaskScheduler::HandlePeriodicTasks() {
-    for (auto& task_info : scheduled_tasks_) {
-        if (task_info.second.IsTimeToRun()) {
-            if (task_info.second.task_->IsPaused()) {
-                Logger::Get()->LogInfo(Log_Level::Info, "Skipping paused task: " + task_info.first);
-                continue; // Skip if the task_ is paused
-            }
-            auto thread = get_available_thread();
-            if (thread) {
-                  // Push the task message to the thread's queue
-                Message task_message{ MessageType::Task, std::shared_ptr<BaseTask>(task_info.second.task_) };  // Package the task in a Message
-
-                thread->pushMsg(task_message);
-                Logger::Get()->LogInfo(Log_Level::Info, "Executing periodic task.");
-                task_info.second.UpdateExecutionTime();
-            }
-            else {
-                // worst case do the task late when thread becomes available
-                Message task_message{ MessageType::Task, std::shared_ptr<BaseTask>(task_info.second.task_) };  // Package the task in a Message
 
-                task_queue.push(task_message);
-            }
-        }
+void TaskScheduler::PeriodicRun::Execute() {
+    if (task_->IsCancellationRequested()) {
+        scheduler_->StopTask(id_);  // the task_'s own token ends the schedule
+        return;
+    }
+    if (!task_->IsPaused()) {
+        task_->Execute();
+        task_->SetCompleted();
     }
+    scheduler_->OnPeriodicDone(id_, this);  // parks it if paused
 }
 
-std::shared_ptr<T_Thread> TaskScheduler::get_available_thread() {
-    for (auto& thread : thread_pool_) {
-        if (thread.second->GetMsg().type == MessageType::Pool) {
-            return thread.second;
+std::optional<int64_t> TaskScheduler::TimeUntilNextRun() {
+    // drop stale entries so the top is a live deadline
+    while (!timer_heap_.empty()) {
+        const TimerEntry& top = timer_heap_.top();
+        auto it = scheduled_tasks_.find(top.id);
+        if (it != scheduled_tasks_.end() && it->second.timerSeq == top.seq) {
+            break;
+        }
+        if (one_shot_timers_.count(top.seq) != 0) {
+            break;
         }
+        timer_heap_.pop();
     }
-    return nullptr;  // No available thread
+    if (timer_heap_.empty()) {
+        return std::nullopt;
+    }
+    int64_t due = timer_heap_.top().deadline - clock_->ElapsedNs();
+    return due > 0 ? due : 0;
 }
 
+void TaskScheduler::ArmTimer(EntityID id, Periodic_Task& pt) {
+    pt.timerSeq = ++timer_seq_;
+    timer_heap_.push(TimerEntry{ pt.Deadline(), pt.timerSeq, id });
+}
 
+void TaskScheduler::CompactTimers() {
+    size_t timers = scheduled_tasks_.size() + one_shot_timers_.size();
+    if (timer_heap_.size() <= 2 * timers + 64) {
+        return;
+    }
+    std::vector<TimerEntry> live;
+    live.reserve(timers);
+    for (auto& task_info : scheduled_tasks_) {
+        if (!task_info.second.parked) {
+            live.push_back(TimerEntry{ task_info.second.Deadline(), task_info.second.timerSeq, task_info.first });
+        }
+    }
+    for (auto& [seq, timer] : one_shot_timers_) {
+        live.push_back(TimerEntry{ timer.deadline, seq, EntityID{} });
+    }
+    timer_heap_ = std::priority_queue<TimerEntry, std::vector<TimerEntry>, std::greater<TimerEntry>>(std::greater<TimerEntry>(), std::move(live));
+}
 
+SchedulerMetrics TaskScheduler::GetMetrics() const {
+    SchedulerMetrics metrics;
+    metrics.bin_depth = task_queue.bin_sizes();
+    metrics.deadline_missed = deadline_queue.Missed();
+    metrics.deadline_cancelled = deadline_queue.Cancelled();
+    metrics.workers.reserve(thread_pool_.size());
+    for (const auto& thread : thread_pool_) {
+        WorkerMetrics& worker = metrics.workers.emplace_back();
+        thread.second->ReadMetrics(worker);
+        metrics.queue_wait.Merge(worker.queue_wait);
+        metrics.execution.Merge(worker.execution);
+    }
+    return metrics;
+}
 
+size_t TaskScheduler::AutoGrain(size_t count) const {
+    // about four chunks per participant so faster threads can take more of the range
+    size_t participants = thread_pool_.size() + 1;
+    size_t grain = count / (participants * 4);
+    return grain > 0 ? grain : 1;
+}
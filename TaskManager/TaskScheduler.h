@@ -8,10 +8,26 @@
 #include <vector>
 #include <mutex>
 #include <chrono>
+#include <optional>
+#include <span>
+#include <algorithm>
+#include <climits>
+#include <coroutine>
+#include <deque>
+#include <functional>
+#include <exception>
 #include "../Utilities/Logger.h"
 #include "T_Thread.h"
 #include "Tasks.h"
-#include "../Utilities/GameTimer.h"
+#include "TaskFuture.h"
+#include "../Utilities/HighResClock.h"
+
+//what a periodic task_ does when it falls behind
+enum class PeriodicPolicy {
+    FixedRate,   // keep the original grid, make up to maxCatchUp missed runs back to back
+    FixedDelay,  // next run is interval after the previous run completed
+    SkipMissed,  // keep the original grid, drop every missed run
+};
 
 class TaskScheduler : public TaskQueue {
 public:
@@ -19,24 +35,32 @@ public:
     //a periodic task_ 
     struct Periodic_Task {
         std::shared_ptr<BaseTask> task_;
-        float nextExecutionTime;  // When to run the task_ next (in seconds)
-        float interval;             // Interval in seconds
-        std::shared_ptr<GameTimer> gameTimer_;  // Pointer to the game timer for accurate timing
+        int64_t nextExecutionTime;  // start of the current interval, clock nanoseconds
+        int64_t interval;           // Interval in nanoseconds
+        std::shared_ptr<HighResClock> clock_;  // the scheduler clock
+        uint64_t timerSeq = 0;      // matches the live entry in the timer heap, older entries are stale
+        bool parked = false;        // paused and taken out of the timer heap until ResumeTask
+        PeriodicPolicy policy = PeriodicPolicy::FixedRate;
+        uint32_t maxCatchUp = 0;    // FixedRate only, most missed runs owed at once
+        uint32_t owedRuns = 0;      // missed runs still to make up
+        bool inFlight = false;      // a run is queued or executing, further ticks coalesce into it
+        std::shared_ptr<BaseTask> runner;  // wraps task_ and reports completion, reused for every run
+        CancellationSource cancel;  // cancels a queued run on StopTask or when the entry is replaced
 
         // Default constructor
         Periodic_Task()
-            : task_(nullptr), nextExecutionTime(0.0f), interval(0.0f), gameTimer_(nullptr) {
+            : task_(nullptr), nextExecutionTime(0), interval(0), clock_(nullptr) {
         }
 
-        // Parameterized constructor for initializing the task_ with interval and game timer
-        Periodic_Task(std::shared_ptr<BaseTask> task_, float interval_, std::shared_ptr<GameTimer> timer)
-            : task_(task_), interval(interval_), gameTimer_(timer) {
-            nextExecutionTime = gameTimer_->TotalTime();  // Initialize to the current game time
+        // Parameterized constructor for initializing the task_ with interval and clock
+        Periodic_Task(std::shared_ptr<BaseTask> task_, int64_t interval_, std::shared_ptr<HighResClock> clock)
+            : task_(task_), interval(interval_), clock_(clock) {
+            nextExecutionTime = clock_->ElapsedNs();  // Initialize to the current clock time
         }
 
-        // Check if it's time to run the task_ based on TotalTime and interval
+        // Check if it's time to run the task_ based on the clock and interval
         bool IsTimeToRun() const {
-            float current_time = gameTimer_->TotalTime();
+            int64_t current_time = clock_->ElapsedNs();
             // If the current time minus the next execution time exceeds the interval, it's time to run
             return (current_time - nextExecutionTime) >= interval;
         }
@@ -45,51 +69,360 @@ public:
         void UpdateExecutionTime() {
             nextExecutionTime += interval;  // Add the interval to the next execution time
         }
+
+        // the clock time at which the task_ is due
+        int64_t Deadline() const {
+            return nextExecutionTime + interval;
+        }
+    };
+    //an entry of the timer heap, ordered by deadline
+    struct TimerEntry {
+        int64_t deadline;
+        uint64_t seq;    // stale once it no longer matches Periodic_Task::timerSeq
+        EntityID id;
+        bool operator>(const TimerEntry& other) const { return deadline > other.deadline; }
+    };
+    /// <ScheduleAwaiter>
+    /// co_await Schedule() suspends the coroutine and resumes it on a worker
+    /// </ScheduleAwaiter>
+    struct ScheduleAwaiter {
+        PriorityLevel priority;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) const;
+        void await_resume() const noexcept {}
     };
-    // Constructor 
-    TaskScheduler();
+    /// <DelayAwaiter>
+    /// co_await Delay(dt) arms a one shot timer and resumes the coroutine on a worker when it fires
+    /// </DelayAwaiter>
+    struct DelayAwaiter {
+        TaskScheduler* scheduler;
+        std::chrono::nanoseconds delay;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) const;
+        void await_resume() const noexcept {}
+    };
+    // Constructor, sizes and places the worker pool from config
+    explicit TaskScheduler(const SchedulerConfig& config = SchedulerConfig::Default());
     //destructor 
     ~TaskScheduler();
-    //add a task_
+    //add a task_, with EarliestDeadline one that has a deadline goes to the deadline queue
     void AddTask(std::shared_ptr<BaseTask> task_);
-    // Add a periodic task_ that executes at fixed intervals
-    void ScheduleTask(std::shared_ptr<BaseTask> task_, float interval);
-    //stop all threads
+    //add a batch of tasks with one lock and one wakeup
+    void AddTasks(std::span<const std::shared_ptr<BaseTask>> tasks);
+    //wrap each callable in a Task and add them as one batch
+    void AddTasks(std::span<const std::function<void()>> task_fns);
+    //run fn on the pool as a pooled task, no shared_ptr, no std::function and no log line
+    //fn has to fit in PooledTask::Function, the handle can be dropped or kept to wait on
+    template <typename F>
+    TaskHandle Spawn(F&& fn, PriorityLevel priority = PriorityLevel::NORMAL);
+    //Spawn that skips fn if token is cancelled by the time it is dequeued, the token takes 16 bytes of the inline storage
+    template <typename F>
+    TaskHandle Spawn(F&& fn, CancellationToken token, PriorityLevel priority = PriorityLevel::NORMAL);
+    //submit a callable with its arguments, the result comes back through the TaskFuture
+    template <typename F, typename... Args>
+    auto Submit(F&& fn, Args&&... args) -> TaskFuture<std::invoke_result_t<std::decay_t<F>&, std::decay_t<Args>&...>>;
+    //run fn on the thread that calls DrainMainThread, the one owning the GL context, the result comes back
+    //through the TaskFuture. waiting on it from that thread never returns
+    //after StopAll the task is cancelled instead of queued
+    template <typename F>
+    auto PostToMain(F&& fn) -> TaskFuture<std::invoke_result_t<std::decay_t<F>&>>;
+    //run PostToMain tasks in post order until budget is used up, at least one if any is queued
+    //call once per frame from the main thread, returns how many ran
+    size_t DrainMainThread(std::chrono::nanoseconds budget);
+    //call fn(i) for every i in [begin, end), chunks of grain indices are spread over the workers
+    //and the calling thread, grain 0 picks one. returns once every index is done
+    template <typename Index, typename F>
+    void ParallelFor(Index begin, Index end, Index grain, F&& fn);
+    //fold map(i) over [begin, end) with reduce, starting from identity in every chunk
+    //reduce has to be associative and commutative, partial results are combined in any order
+    template <typename Index, typename T, typename MapFn, typename ReduceFn>
+    T ParallelReduce(Index begin, Index end, Index grain, T identity, MapFn&& map, ReduceFn&& reduce);
+    // Add a periodic task_ that executes at fixed intervals, at most one run is queued or running at a time
+    void ScheduleTask(std::shared_ptr<BaseTask> task_, std::chrono::nanoseconds interval,
+        PeriodicPolicy policy = PeriodicPolicy::FixedRate, uint32_t max_catch_up = 1);
+    // ScheduleTask with the interval in milliseconds
+    void ScheduleTask(std::shared_ptr<BaseTask> task_, float interval_ms,
+        PeriodicPolicy policy = PeriodicPolicy::FixedRate, uint32_t max_catch_up = 1);
+    //run fn on the pool once delay has passed on get_clock(), PauseAll holds it back like a periodic task_
+    //a timer still pending at StopAll is dropped without running fn
+    void RunAfter(std::chrono::nanoseconds delay, std::function<void()> fn);
+    //co_await to continue the calling coroutine on a worker
+    ScheduleAwaiter Schedule(PriorityLevel priority = PriorityLevel::NORMAL);
+    //co_await to continue the calling coroutine on a worker once delay has passed, no thread waits meanwhile
+    DelayAwaiter Delay(std::chrono::nanoseconds delay);
+    //queue handle.resume() on the pool, on the calling worker's own deque when called from one
+    static void ResumeOnPool(std::coroutine_handle<> handle, PriorityLevel priority = PriorityLevel::NORMAL);
+    //stop all threads, every task_ that has not run is cancelled so its future reports TaskCancelled
+    //and a Spawn handle counts as done, a Spawn callable that never ran is dropped unrun
     void StopAll();
     //stop a task_
-    void StopTask(const std::string& id);
+    void StopTask(EntityID id);
 
-    //pause a task_
-    void PauseTask(std::string id);
-    //resume a task_
-    void ResumeTask(std::string id);
+    //pause a periodic task_, it is taken out of the timer heap until ResumeTask
+    void PauseTask(EntityID id);
+    //pause any task_, a worker that dequeues it sets it aside instead of running it
+    void PauseTask(const std::shared_ptr<BaseTask>& task_);
+    //resume a periodic task_ or one a worker has set aside
+    void ResumeTask(EntityID id);
+    //resume any task_, a set aside one goes back in the queue at its own priority
+    void ResumeTask(const std::shared_ptr<BaseTask>& task_);
+    //park every worker and the timer dispatcher, nothing runs and no thread uses the cpu until ResumeAll
+    void PauseAll();
+    //wake the pool, periodic deadlines move on by the time spent paused
+    void ResumeAll();
     //return a pointer to the system scheduler clock to use for timings
-    std::shared_ptr<GameTimer> get_clock();
+    std::shared_ptr<HighResClock> get_clock();
+    //the deadline for BaseTask::SetDeadline at elapsed time on get_clock()
+    std::chrono::steady_clock::time_point DeadlineAt(std::chrono::nanoseconds elapsed) const;
         //return a shared pointer to the threadpool map
     std::shared_ptr<std::unordered_map<std::thread::id, std::shared_ptr<T_Thread>>> GetThreadMap();
 
     //posts a message to all threads in the pool
     void PostMessage(const Message& msg);
+    //snapshot of queue depths, per worker counters and latency histograms, aggregated on the calling thread
+    SchedulerMetrics GetMetrics() const;
 private:
-    void Worker();
-    bool AllQueuesEmpty();
+    /// <PeriodicRun>
+    /// runs a periodic task_ and tells the scheduler when it finished
+    /// </PeriodicRun>
+    class PeriodicRun : public BaseTask {
+    public:
+        PeriodicRun(TaskScheduler* scheduler, EntityID id, std::shared_ptr<BaseTask> task_)
+            : scheduler_(scheduler), id_(id), task_(std::move(task_)) {
+        }
+        virtual void Execute() override;
+    private:
+        TaskScheduler* scheduler_;
+        EntityID id_;
+        std::shared_ptr<BaseTask> task_;
+    };
 
+    void Worker();
 
-    //handle regular tasks
-    void HandleRegularTasks();
     //handle periodic tasks
     void HandlePeriodicTasks();
-    //return a thread thats pooling available for a task_
-    std::shared_ptr<T_Thread> get_available_thread();
+    //nanoseconds until the earliest unpaused periodic task_ is due, nullopt if none
+    std::optional<int64_t> TimeUntilNextRun();
+    //push the periodic task_'s next deadline onto the timer heap
+    void ArmTimer(EntityID id, Periodic_Task& pt);
+    //queue one run of a periodic task_
+    void DispatchPeriodic(Periodic_Task& pt);
+    //a periodic run finished, re-arm or make up an owed run
+    void OnPeriodicDone(EntityID id, const BaseTask* runner);
+    //drop stale heap entries once they outnumber the live timers
+    void CompactTimers();
+    //requeue a task_ workers set aside while it was paused, false if there is none
+    bool Unpark(EntityID id);
+    //run participant(claim) on the calling thread and on helper workers, claim(chunk) hands out
+    //chunk indices below chunks until they run out
+    template <typename Participant>
+    void RunParallel(size_t chunks, Participant& participant);
+    //grain to use when the caller passes 0
+    size_t AutoGrain(size_t count) const;
+    //queue a pooled job, on the calling worker's own deque when called from one
+    static void PushJob(TaskHandle job);
+
+    //a RunAfter timer, the task is built up front and queued with AddTask when due
+    struct OneShotTimer {
+        int64_t deadline;
+        std::shared_ptr<Task> task;
+    };
 
-    std::unordered_map<std::string, Periodic_Task> scheduled_tasks_; //scheduled tasks mapped
+    std::unordered_map<EntityID, Periodic_Task> scheduled_tasks_; //scheduled tasks mapped
+    std::priority_queue<TimerEntry, std::vector<TimerEntry>, std::greater<TimerEntry>> timer_heap_; //next deadlines, earliest on top
+    uint64_t timer_seq_ = 0; //last sequence number handed to ArmTimer
+    std::unordered_map<uint64_t, OneShotTimer> one_shot_timers_; //RunAfter timers by their timer heap sequence
+    std::mutex main_mutex_;
+    std::deque<std::shared_ptr<BaseTask>> main_tasks_; //PostToMain tasks, guarded by main_mutex_
+    bool main_closed_ = false; //set by StopAll, PostToMain cancels from then on, guarded by main_mutex_
     std::unordered_map<std::thread::id, std::shared_ptr<T_Thread>> thread_pool_; //the thread pool mapped
-    std::shared_ptr<GameTimer> clock_;  // Add clock to track time
-    std::vector<std::queue<std::shared_ptr<BaseTask>>> priority_bins_;  // priority bins of tasks
+    std::shared_ptr<HighResClock> clock_;  // Add clock to track time
+    bool edf_ = false;                  // DispatchMode::EarliestDeadline
+    DeadlineMissPolicy miss_policy_ = DeadlineMissPolicy::Report; // travels with every task_ this scheduler queues by deadline
     MessageQueue global_task_queue;
     std::mutex scheduledTasksMutex;      // Mutex for safe task_ handling
-    std::mutex binsMutex;                 // Mutex for priority bins
-    std::condition_variable cv;            // Condition variable for thread synchronization
-    bool stopFlag = false;                // stop flag 
+    std::condition_variable cv;            // wakes the dispatcher when periodic tasks change or on stop
+    bool stopFlag = false;                // stop flag, guarded by scheduledTasksMutex
+    bool paused_ = false;                 // PauseAll, guarded by scheduledTasksMutex
+    int64_t pausedAt_ = 0;                // clock_ time when PauseAll was called
     std::thread workerThread;             // Worker thread
 };
+
+template <typename F, typename... Args>
+auto TaskScheduler::Submit(F&& fn, Args&&... args) -> TaskFuture<std::invoke_result_t<std::decay_t<F>&, std::decay_t<Args>&...>> {
+    using R = std::invoke_result_t<std::decay_t<F>&, std::decay_t<Args>&...>;
+    auto call = [fn = std::forward<F>(fn), ... args = std::forward<Args>(args)]() mutable -> R {
+        return std::invoke(fn, args...);
+    };
+    // task_, callable, arguments and result share one allocation
+    auto task_ = std::make_shared<FutureTask<R, decltype(call)>>(this, std::move(call));
+    AddTask(task_);
+    return TaskFuture<R>(task_);
+}
+
+template <typename F>
+auto TaskScheduler::PostToMain(F&& fn) -> TaskFuture<std::invoke_result_t<std::decay_t<F>&>> {
+    using R = std::invoke_result_t<std::decay_t<F>&>;
+    auto task_ = std::make_shared<FutureTask<R, std::decay_t<F>>>(this, std::forward<F>(fn));
+    bool closed;
+    {
+        std::lock_guard<std::mutex> lock(main_mutex_);
+        closed = main_closed_;
+        if (!closed) {
+            main_tasks_.push_back(task_);
+        }
+    }
+    if (closed) {
+        task_->Cancel();  // outside the lock, a continuation may post again
+    }
+    return TaskFuture<R>(task_);
+}
+
+template <typename F>
+TaskHandle TaskScheduler::Spawn(F&& fn, PriorityLevel priority) {
+    TaskHandle job = TaskHandle::Adopt(PooledTask::Create(std::forward<F>(fn), priority));
+    PushJob(job);
+    return job;
+}
+
+template <typename F>
+TaskHandle TaskScheduler::Spawn(F&& fn, CancellationToken token, PriorityLevel priority) {
+    return Spawn([fn = std::forward<F>(fn), token = std::move(token)]() mutable {
+        if (!token.IsCancelled()) {
+            fn();
+        }
+    }, priority);
+}
+
+template <typename R>
+template <typename F>
+auto TaskFuture<R>::then(F&& fn) const {
+    using Next = std::conditional_t<std::is_void_v<R>,
+        std::invoke_result<std::decay_t<F>&>,
+        std::invoke_result<std::decay_t<F>&, const value_type&>>::type;
+    std::shared_ptr<FutureState<R>> parent = state_;
+    auto call = [parent, fn = std::forward<F>(fn)]() mutable -> Next {
+        if constexpr (std::is_void_v<R>) {
+            parent->Value();  // rethrows the parent's exception into this future
+            return std::invoke(fn);
+        }
+        else {
+            return std::invoke(fn, parent->Value());
+        }
+    };
+    TaskScheduler* scheduler = parent->GetScheduler();
+    auto next = std::make_shared<FutureTask<Next, decltype(call)>>(scheduler, std::move(call));
+    parent->OnReady([scheduler, next]() { scheduler->AddTask(next); });
+    return TaskFuture<Next>(next);
+}
+
+template <typename Participant>
+void TaskScheduler::RunParallel(size_t chunks, Participant& participant) {
+    struct State {
+        std::atomic<size_t> next{ 0 };       // next chunk to hand out
+        size_t chunks = 0;
+        std::atomic<uint32_t> active{ 0 };   // helpers inside participant
+        std::exception_ptr error;            // first exception thrown by a participant
+        std::mutex errorMutex;
+        Participant* participant = nullptr;  // lives on the caller's stack
+    };
+    auto state = std::make_shared<State>();
+    state->chunks = chunks;
+    state->participant = &participant;
+
+    auto run = [](State& st) {
+        try {
+            (*st.participant)([&st](size_t& chunk) {
+                // seq_cst pairs with the helper's active increment and next load, the caller's last
+                // failed claim must be ordered before its load of active or a late helper is missed
+                chunk = st.next.fetch_add(1, std::memory_order_seq_cst);
+                return chunk < st.chunks;
+            });
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(st.errorMutex);
+            if (!st.error) st.error = std::current_exception();
+            st.next.store(st.chunks, std::memory_order_seq_cst);  // stop handing out chunks, ordered like a claim
+        }
+    };
+
+    // one helper per extra chunk, at most one per worker, each a pooled task
+    size_t helpers = std::min(chunks - 1, thread_pool_.size());
+    for (size_t i = 0; i < helpers; ++i) {
+        Spawn([state, run]() {
+            state->active.fetch_add(1, std::memory_order_seq_cst);
+            // a helper that starts after the work ran out must not touch the caller's participant
+            if (state->next.load(std::memory_order_seq_cst) < state->chunks) {
+                run(*state);
+            }
+            if (state->active.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                state->active.notify_all();
+            }
+        });
+    }
+
+    // the calling thread works too instead of blocking
+    run(*state);
+
+    // wait only for helpers that actually picked up chunks, queued ones will find nothing left
+    uint32_t active = state->active.load(std::memory_order_seq_cst);
+    while (active != 0) {
+        state->active.wait(active, std::memory_order_acquire);
+        active = state->active.load(std::memory_order_seq_cst);
+    }
+
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+
+template <typename Index, typename F>
+void TaskScheduler::ParallelFor(Index begin, Index end, Index grain, F&& fn) {
+    if (end <= begin) return;
+    size_t count = static_cast<size_t>(end - begin);
+    size_t chunk_size = grain > 0 ? static_cast<size_t>(grain) : AutoGrain(count);
+    size_t chunks = (count + chunk_size - 1) / chunk_size;
+
+    auto participant = [&](auto&& claim) {
+        size_t chunk;
+        while (claim(chunk)) {
+            Index first = begin + static_cast<Index>(chunk * chunk_size);
+            Index last = static_cast<size_t>(end - first) > chunk_size ? first + static_cast<Index>(chunk_size) : end;
+            for (Index i = first; i < last; ++i) {
+                fn(i);
+            }
+        }
+    };
+    RunParallel(chunks, participant);
+}
+
+template <typename Index, typename T, typename MapFn, typename ReduceFn>
+T TaskScheduler::ParallelReduce(Index begin, Index end, Index grain, T identity, MapFn&& map, ReduceFn&& reduce) {
+    if (end <= begin) return identity;
+    size_t count = static_cast<size_t>(end - begin);
+    size_t chunk_size = grain > 0 ? static_cast<size_t>(grain) : AutoGrain(count);
+    size_t chunks = (count + chunk_size - 1) / chunk_size;
+
+    T result = identity;
+    std::mutex resultMutex;
+    auto participant = [&](auto&& claim) {
+        // each participant folds all of its chunks locally and merges once
+        T partial = identity;
+        size_t chunk;
+        bool worked = false;
+        while (claim(chunk)) {
+            Index first = begin + static_cast<Index>(chunk * chunk_size);
+            Index last = static_cast<size_t>(end - first) > chunk_size ? first + static_cast<Index>(chunk_size) : end;
+            for (Index i = first; i < last; ++i) {
+                partial = reduce(partial, map(i));
+            }
+            worked = true;
+        }
+        if (worked) {
+            std::lock_guard<std::mutex> lock(resultMutex);
+            result = reduce(result, partial);
+        }
+    };
+    RunParallel(chunks, participant);
+    return result;
+}
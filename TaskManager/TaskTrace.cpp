@@ -0,0 +1,162 @@
+#include "TaskTrace.h"
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+    struct TraceEvent {
+        int64_t timestamp_ns;
+        uint64_t id;
+        TraceEventType type;
+    };
+
+    // one per thread, only its thread writes events, count publishes them to the dump
+    struct ThreadBuffer {
+        uint32_t tid = 0;
+        std::string name;  // guarded by Registry::mtx
+        std::unique_ptr<TraceEvent[]> events{ new TraceEvent[TaskTrace::kEventsPerThread] };
+        std::atomic<size_t> count{ 0 };
+        std::atomic<uint64_t> dropped{ 0 };
+    };
+
+    struct Registry {
+        std::mutex mtx;
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;  // kept after a thread exits so it still shows up
+        int64_t origin_ns = 0;                               // timestamps are written relative to this
+    };
+
+    // leaked on purpose, threads may still record during static destruction
+    Registry& GetRegistry() {
+        static Registry* registry = new Registry();
+        return *registry;
+    }
+
+    int64_t NowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    thread_local ThreadBuffer* thread_buffer = nullptr;
+
+    ThreadBuffer& CurrentBuffer() {
+        if (thread_buffer == nullptr) {
+            auto buffer = std::make_shared<ThreadBuffer>();
+            Registry& registry = GetRegistry();
+            std::lock_guard<std::mutex> lock(registry.mtx);
+            if (registry.buffers.empty()) {
+                registry.origin_ns = NowNs();
+            }
+            buffer->tid = static_cast<uint32_t>(registry.buffers.size() + 1);
+            buffer->name = "thread " + std::to_string(buffer->tid);
+            registry.buffers.push_back(buffer);
+            thread_buffer = buffer.get();
+        }
+        return *thread_buffer;
+    }
+
+    std::string_view EventName(TraceEventType type) {
+        switch (type) {
+        case TraceEventType::Enqueue: return "enqueue";
+        case TraceEventType::Dispatch: return "dispatch";
+        case TraceEventType::Steal: return "steal";
+        case TraceEventType::Start: return "start";
+        case TraceEventType::End: return "end";
+        }
+        return "event";
+    }
+}
+
+void TaskTrace::Record(TraceEventType type, uint64_t id) {
+    ThreadBuffer& buffer = CurrentBuffer();
+    size_t count = buffer.count.load(std::memory_order_relaxed);
+    if (count == kEventsPerThread) {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer.events[count] = TraceEvent{ NowNs(), id, type };
+    buffer.count.store(count + 1, std::memory_order_release);
+}
+
+void TaskTrace::SetThreadName(const char* name) {
+    ThreadBuffer& buffer = CurrentBuffer();
+    std::lock_guard<std::mutex> lock(GetRegistry().mtx);
+    buffer.name = std::string(name) + " " + std::to_string(buffer.tid);
+}
+
+bool TaskTrace::WriteChromeJson(const std::string& path) {
+    std::ofstream out(path, std::ios::out | std::ios::trunc);
+    if (!out.is_open()) {
+        return false;
+    }
+    WriteChromeJson(out);
+    return true;
+}
+
+void TaskTrace::WriteChromeJson(std::ostream& out) {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mtx);
+
+    std::string json = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    auto it = std::back_inserter(json);
+    bool first = true;
+    auto separator = [&]() {
+        if (!first) json += ",\n";
+        first = false;
+    };
+
+    for (const auto& buffer : registry.buffers) {
+        separator();
+        std::format_to(it, R"({{"ph":"M","pid":1,"tid":{},"name":"thread_name","args":{{"name":"{}"}}}})",
+            buffer->tid, buffer->name);
+        uint64_t dropped = buffer->dropped.load(std::memory_order_relaxed);
+        if (dropped != 0) {
+            separator();
+            std::format_to(it, R"({{"ph":"i","s":"t","pid":1,"tid":{},"ts":0,"name":"{} events dropped"}})",
+                buffer->tid, dropped);
+        }
+
+        size_t count = buffer->count.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; ++i) {
+            const TraceEvent& event = buffer->events[i];
+            double ts = static_cast<double>(event.timestamp_ns - registry.origin_ns) / 1000.0;  // microseconds
+            separator();
+            switch (event.type) {
+            case TraceEventType::Start:
+                // the flow arrow from the enqueue ends on this slice
+                std::format_to(it, R"({{"ph":"f","bp":"e","cat":"task","name":"queued","id":{},"pid":1,"tid":{},"ts":{:.3f}}},)"
+                    "\n" R"({{"ph":"B","cat":"task","name":"task","pid":1,"tid":{},"ts":{:.3f},"args":{{"id":{}}}}})",
+                    event.id, buffer->tid, ts, buffer->tid, ts, event.id);
+                break;
+            case TraceEventType::End:
+                std::format_to(it, R"({{"ph":"E","pid":1,"tid":{},"ts":{:.3f}}})", buffer->tid, ts);
+                break;
+            case TraceEventType::Enqueue:
+                std::format_to(it, R"({{"ph":"s","cat":"task","name":"queued","id":{},"pid":1,"tid":{},"ts":{:.3f}}},)"
+                    "\n" R"({{"ph":"i","s":"t","cat":"task","name":"enqueue","pid":1,"tid":{},"ts":{:.3f},"args":{{"id":{}}}}})",
+                    event.id, buffer->tid, ts, buffer->tid, ts, event.id);
+                break;
+            default:
+                std::format_to(it, R"({{"ph":"i","s":"t","cat":"task","name":"{}","pid":1,"tid":{},"ts":{:.3f},"args":{{"id":{}}}}})",
+                    EventName(event.type), buffer->tid, ts, event.id);
+                break;
+            }
+        }
+    }
+    json += "\n]}\n";
+    out << json;
+}
+
+void TaskTrace::Clear() {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mtx);
+    for (const auto& buffer : registry.buffers) {
+        buffer->count.store(0, std::memory_order_release);
+        buffer->dropped.store(0, std::memory_order_relaxed);
+    }
+    registry.origin_ns = NowNs();
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+// build with TASK_TRACE=1 to record scheduler events, with 0 every trace point compiles to nothing
+#ifndef TASK_TRACE
+#define TASK_TRACE 0
+#endif
+
+enum class TraceEventType : uint8_t {
+    Enqueue,   // task pushed onto a deque or the shared queue
+    Dispatch,  // task taken by a worker from its own deque or the shared queue
+    Steal,     // task taken from another worker's deque
+    Start,     // Execute begins
+    End        // Execute returned
+};
+
+/// <TaskTrace>
+/// per thread event buffers for the scheduler timeline, written without locks and
+/// timestamped with the steady clock. WriteChromeJson dumps them as Chrome trace events,
+/// open the file in Perfetto or chrome://tracing. a full buffer drops new events
+/// use the TASK_TRACE_ macros so the calls vanish when tracing is compiled out
+/// </TaskTrace>
+class TaskTrace {
+public:
+    static constexpr size_t kEventsPerThread = size_t(1) << 18;  // allocated on a thread's first event
+
+    TaskTrace() = delete;
+
+    // append an event for the task_ with this id to the calling thread's buffer
+    static void Record(TraceEventType type, uint64_t id);
+    // name the calling thread in the trace
+    static void SetThreadName(const char* name);
+    // write every recorded event as Chrome trace JSON, false if the file could not be opened
+    static bool WriteChromeJson(const std::string& path);
+    static void WriteChromeJson(std::ostream& out);
+    // forget all events, only call while no thread is recording
+    static void Clear();
+};
+
+#if TASK_TRACE
+#define TASK_TRACE_EVENT(type, id) TaskTrace::Record(TraceEventType::type, static_cast<uint64_t>(id))
+#define TASK_TRACE_THREAD_NAME(name) TaskTrace::SetThreadName(name)
+#else
+#define TASK_TRACE_EVENT(type, id) ((void)0)
+#define TASK_TRACE_THREAD_NAME(name) ((void)0)
+#endif
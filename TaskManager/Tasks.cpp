@@ -1,33 +1,50 @@
 #include "Tasks.h"
 
 void BaseTask::PauseTask() {
-    std::lock_guard<std::mutex> lock(task_mutex_);
-    paused_ = true;
+    state_.fetch_or(kPaused, std::memory_order_release);
 }
 void BaseTask::ResumeTask() {
-    std::lock_guard<std::mutex> lock(task_mutex_);
-    paused_ = false;
+    state_.fetch_and(~kPaused, std::memory_order_release);
 }
 void BaseTask::SetPriority(const PriorityLevel& priority_in) {
-    std::lock_guard<std::mutex> lock(task_mutex_);
-    priority_ = priority_in;
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    uint32_t next;
+    do {
+        next = (state & ~kPriorityMask) | static_cast<uint32_t>(priority_in);
+    } while (!state_.compare_exchange_weak(state, next, std::memory_order_release, std::memory_order_relaxed));
 }; //set priority level
 PriorityLevel BaseTask::GetPriority() {
-    std::lock_guard<std::mutex> lock(task_mutex_);
-    return priority_;
+    return static_cast<PriorityLevel>(state_.load(std::memory_order_acquire) & kPriorityMask);
 }; //return the tasks priority level
 void BaseTask::SetCompleted() {
-    std::lock_guard<std::mutex> lock(task_mutex_);
-    completed_ = true;
+    state_.fetch_or(kCompleted, std::memory_order_release);
 }; //set the task_ as completed
 bool BaseTask::IsCompleted() {
-    std::lock_guard<std::mutex> lock(task_mutex_);
-    return completed_;
+    return (state_.load(std::memory_order_acquire) & kCompleted) != 0;
 } //return if the task_ is completed or not
 bool BaseTask::IsPaused() {
-    std::lock_guard<std::mutex> lock(task_mutex_);
-    return paused_;
+    return (state_.load(std::memory_order_acquire) & kPaused) != 0;
 } //return if the task_ is paused
+void BaseTask::SetDeadline(std::chrono::steady_clock::time_point deadline, std::chrono::nanoseconds estimate) {
+    int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+    estimate_ns_.store(estimate.count(), std::memory_order_relaxed);
+    deadline_ns_.store(ns != 0 ? ns : 1, std::memory_order_release);
+}
+bool BaseTask::HasDeadline() {
+    return deadline_ns_.load(std::memory_order_acquire) != 0;
+}
+int64_t BaseTask::DeadlineNs() {
+    return deadline_ns_.load(std::memory_order_acquire);
+}
+int64_t BaseTask::EstimateNs() {
+    return estimate_ns_.load(std::memory_order_relaxed);
+}
+void BaseTask::Cancel() {
+    state_.fetch_or(kCancelled | kCompleted, std::memory_order_release);
+}
+bool BaseTask::IsCancelled() {
+    return (state_.load(std::memory_order_acquire) & kCancelled) != 0;
+}
 
 Task::Task(std::function<void()> task_fn)
     : task_fn_(task_fn) {
@@ -39,8 +56,7 @@ void Task::Execute() {
         SetCompleted();
     }
     catch (const std::exception& e) {
-        std::string tmp = e.what();
-        Logger::Get()->LogInfo(Log_Level::Error, "Error executing task: " + tmp);
+        LOG_ERROR("Error executing task: {}", e.what());
     }
 };
 
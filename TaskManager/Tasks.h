@@ -1,26 +1,42 @@
 #pragma once
 #pragma once
 #include <functional>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
 #include <any>
 #include <future>
-#include "..\Utilities\Entity.h"
-#include "..\Utilities\Logger.h"
+#include "../Utilities/Entity.h"
+#include "../Utilities/Logger.h"
+#include "CancellationToken.h"
 
 
 enum class PriorityLevel {
     SCHEDULED = 0,
-    EXCLUSIVE = 1,
+    EXCLUSIVE = 1,  // runs with no other task running, must not wait on another task. once one is
+                    // dequeued no task starts until the running ones finish, so a task that blocks on
+                    // queued work (TaskFuture::get, TaskGraph::Wait, a nested ParallelFor) deadlocks the pool
     VERY_HIGH = 2,
     HIGH = 3,
     MEDIUM = 4,
     NORMAL = 5,
     LOW = 6,
-    BLOCKED = 7
+    BLOCKED = 7     // only runs when nothing else is queued, never aged
+};
+
+//the error a cancelled task_'s future reports
+class TaskCancelled : public std::runtime_error {
+public:
+    TaskCancelled() : std::runtime_error("task cancelled") {}
 };
 
 
 /// <BaseTask>
 ///  BaseTask is a partial virtual base class of a Task
+///  priority, completed and paused share one atomic word so the accessors never lock
+///  the deadline is steady_clock nanoseconds, only dispatched by deadline in DispatchMode::EarliestDeadline
+///  a task_ whose token is cancelled by the time a worker dequeues it is dropped through Cancel unrun
 /// </BaseTask>
 class BaseTask : public Entity {
 public:
@@ -36,12 +52,28 @@ public:
     virtual void SetCompleted(); //set the task_ as completed
     virtual bool IsCompleted(); //return if the task_ is completed or not
     virtual bool IsPaused();//return if the task_ is paused
+    //set when the task_ has to be done by, estimate is how long it expects to run
+    virtual void SetDeadline(std::chrono::steady_clock::time_point deadline, std::chrono::nanoseconds estimate = {});
+    virtual bool HasDeadline(); //return if a deadline is set
+    virtual int64_t DeadlineNs(); //the deadline in steady_clock nanoseconds, 0 if none
+    virtual int64_t EstimateNs(); //the expected run time in nanoseconds
+    virtual void Cancel(); //drop the task_ without running it, it counts as completed
+    virtual bool IsCancelled(); //return if the task_ was cancelled
+    //set the token that can cancel the task_, before it is added
+    void SetCancellationToken(CancellationToken token) { token_ = std::move(token); }
+    const CancellationToken& GetCancellationToken() const { return token_; }
+    //return if the token was cancelled, poll this from a long Execute
+    bool IsCancellationRequested() const { return token_.IsCancelled(); }
 protected:
-    PriorityLevel priority_ = PriorityLevel::NORMAL; //the priority level of the task_
-    bool completed_ = false; //flag for whether the taks is completed
-    bool paused_ = false;
-    std::mutex task_mutex_;
-    std::condition_variable cv;
+    static constexpr uint32_t kPriorityMask = 0xFF;   //low byte holds the PriorityLevel
+    static constexpr uint32_t kCompleted = 1u << 8;   //set once the task_ has run
+    static constexpr uint32_t kPaused = 1u << 9;      //set while the task_ is paused
+    static constexpr uint32_t kCancelled = 1u << 10;  //set if the task_ was dropped instead of run
+
+    std::atomic<uint32_t> state_{ static_cast<uint32_t>(PriorityLevel::NORMAL) }; //priority and flags
+    std::atomic<int64_t> deadline_ns_{ 0 }; //0 is no deadline
+    std::atomic<int64_t> estimate_ns_{ 0 };
+    CancellationToken token_; //set before the task_ is queued, read only after
 };
 
 
@@ -56,8 +88,5 @@ public:
     virtual void Execute() override;
 
 private:
-
-    static std::vector<std::any> results_; //results
-    static std::mutex resultsMutex;  // Mutex for thread-safety
     std::function<void()> task_fn_; //the tasks related function
 };
@@ -0,0 +1,152 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+
+/// <WorkStealingDeque>
+/// lock free Chase-Lev deque (weak memory model version by Le, Pop, Cohen and Nardelli)
+/// the owning thread pushes and pops at the bottom, any other thread steals from the top
+/// it only stores pointers and never owns what it holds
+/// </WorkStealingDeque>
+template <typename T>
+class WorkStealingDeque {
+    static_assert(std::is_pointer_v<T>, "WorkStealingDeque only holds pointers");
+public:
+    // Constructor, capacity is rounded up to a power of two
+    explicit WorkStealingDeque(int64_t capacity = 256);
+    // Non-copyable
+    WorkStealingDeque(const WorkStealingDeque& other) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque& other) = delete;
+    // Destructor
+    ~WorkStealingDeque();
+    // Push an item on the bottom (owner thread only)
+    void push(T item);
+    // Pop an item from the bottom, nullptr if empty (owner thread only)
+    T pop();
+    // Steal an item from the top, nullptr if empty or the race was lost (any thread)
+    T steal();
+    // Approximate number of items, exact only on the owner thread
+    int64_t size() const;
+    bool empty() const;
+
+private:
+    // circular array of atomic slots
+    struct Buffer {
+        int64_t capacity;
+        int64_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+
+        explicit Buffer(int64_t capacity_)
+            : capacity(capacity_), mask(capacity_ - 1), slots(new std::atomic<T>[capacity_]) {
+        }
+        T get(int64_t i) const {
+            return slots[i & mask].load(std::memory_order_relaxed);
+        }
+        void put(int64_t i, T item) {
+            slots[i & mask].store(item, std::memory_order_relaxed);
+        }
+        // copy the live range into a buffer twice the size
+        Buffer* grow(int64_t bottom, int64_t top) const {
+            Buffer* bigger = new Buffer(capacity * 2);
+            for (int64_t i = top; i != bottom; ++i) {
+                bigger->put(i, get(i));
+            }
+            return bigger;
+        }
+    };
+
+    alignas(64) std::atomic<int64_t> top_;     // thieves take from here
+    alignas(64) std::atomic<int64_t> bottom_;  // owner pushes and pops here
+    alignas(64) std::atomic<Buffer*> buffer_;  // current buffer
+    std::vector<std::unique_ptr<Buffer>> retired_; // old buffers a thief may still be reading, freed on destruction
+};
+
+template <typename T>
+WorkStealingDeque<T>::WorkStealingDeque(int64_t capacity)
+    : top_(0), bottom_(0) {
+    int64_t rounded = 1;
+    while (rounded < capacity) {
+        rounded <<= 1;
+    }
+    buffer_.store(new Buffer(rounded), std::memory_order_relaxed);
+}
+
+template <typename T>
+WorkStealingDeque<T>::~WorkStealingDeque() {
+    delete buffer_.load(std::memory_order_relaxed);
+}
+
+template <typename T>
+void WorkStealingDeque<T>::push(T item) {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_acquire);
+    Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+
+    if (b - t > buffer->capacity - 1) {
+        // full, grow and keep the old buffer alive for any thief still reading it
+        Buffer* bigger = buffer->grow(b, t);
+        retired_.emplace_back(buffer);
+        buffer_.store(bigger, std::memory_order_release);
+        buffer = bigger;
+    }
+
+    buffer->put(b, item);
+    bottom_.store(b + 1, std::memory_order_release);  // publishes the item to thieves
+}
+
+template <typename T>
+T WorkStealingDeque<T>::pop() {
+    int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+
+    if (t > b) {
+        // empty, restore bottom
+        bottom_.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    T item = buffer->get(b);
+    if (t == b) {
+        // last item, race the thieves for it
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            item = nullptr;
+        }
+        bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return item;
+}
+
+template <typename T>
+T WorkStealingDeque<T>::steal() {
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom_.load(std::memory_order_acquire);
+
+    if (t >= b) {
+        return nullptr;
+    }
+
+    Buffer* buffer = buffer_.load(std::memory_order_acquire);
+    T item = buffer->get(t);
+    if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return nullptr;  // lost the race to the owner or another thief
+    }
+    return item;
+}
+
+template <typename T>
+int64_t WorkStealingDeque<T>::size() const {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    return b > t ? b - t : 0;
+}
+
+template <typename T>
+bool WorkStealingDeque<T>::empty() const {
+    return size() == 0;
+}
@@ -0,0 +1,104 @@
+// BatchBench, compares submitting tasks one AddTask at a time with handing them over in one AddTasks call
+// build with the TaskManager and Utilities sources
+//
+// usage: BatchBench [--tasks N] [--runs N]
+//   --tasks  tasks per batch (default 100000)
+//   --runs   runs per mode, the best one is reported (default 5)
+// tasks are created before the clock starts, the submit column is the time spent in the calls and
+// the total column runs until the last task has finished
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "BenchCommon.h"
+#include "../TaskManager/TaskManager.h"
+#include "../Utilities/HighResClock.h"
+
+namespace {
+    struct Options {
+        size_t tasks = 100000;
+        size_t runs = 5;
+    };
+
+    enum class Mode { Loop, Batch, BatchFns };
+
+    struct Result {
+        double submit_ns = 1e300;  // per task
+        double total_ns = 1e300;   // per task
+    };
+
+    void Run(TaskScheduler& scheduler, Mode mode, size_t count, Result& best) {
+        std::atomic<size_t> done{ 0 };
+        auto body = [&done]() { done.fetch_add(1, std::memory_order_relaxed); };
+        std::vector<std::shared_ptr<BaseTask>> tasks;
+        std::vector<std::function<void()>> fns;
+        if (mode == Mode::BatchFns) {
+            fns.assign(count, body);
+        }
+        else {
+            tasks.reserve(count);
+            for (size_t i = 0; i < count; ++i) {
+                tasks.push_back(std::make_shared<Task>(body));
+            }
+        }
+
+        int64_t begin = HighResClock::Now();
+        switch (mode) {
+        case Mode::Loop:
+            for (const auto& task : tasks) {
+                scheduler.AddTask(task);
+            }
+            break;
+        case Mode::Batch:
+            scheduler.AddTasks(tasks);
+            break;
+        case Mode::BatchFns:
+            scheduler.AddTasks(fns);
+            break;
+        }
+        int64_t submitted = HighResClock::Now();
+        while (done.load(std::memory_order_relaxed) < count) {
+            std::this_thread::yield();
+        }
+        int64_t end = HighResClock::Now();
+
+        best.submit_ns = std::min(best.submit_ns, static_cast<double>(submitted - begin) / count);
+        best.total_ns = std::min(best.total_ns, static_cast<double>(end - begin) / count);
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!Bench::ParseArgs(argc, argv, { Bench::Number("--tasks", options.tasks, 1), Bench::Number("--runs", options.runs, 1) })) {
+        return Bench::Usage("BatchBench [--tasks N] [--runs N]");
+    }
+
+    std::shared_ptr<TaskScheduler> scheduler = TaskManager::Scheduler();
+    struct Row { const char* name; Mode mode; Result result; };
+    Row rows[] = {
+        { "AddTask loop", Mode::Loop, {} },
+        { "AddTasks(tasks)", Mode::Batch, {} },
+        { "AddTasks(fns)", Mode::BatchFns, {} },
+    };
+    // a round runs every submit mode once, so a slow stretch of the machine costs the loop and both batches alike
+    for (size_t run = 0; run < options.runs; ++run) {
+        for (Row& row : rows) {
+            Run(*scheduler, row.mode, options.tasks, row.result);
+        }
+    }
+
+    std::cout << std::format("{} tasks per batch, best of {}, ns per task\n", options.tasks, options.runs);
+    std::cout << std::format("{:<16}  {:>9}  {:>9}  {:>12}\n", "mode", "submit", "total", "tasks/s");
+    for (const Row& row : rows) {
+        std::cout << std::format("{:<16}  {:>9.1f}  {:>9.1f}  {:>12.0f}\n",
+            row.name, row.result.submit_ns, row.result.total_ns, 1e9 / row.result.total_ns);
+    }
+
+    scheduler->StopAll();
+    return 0;
+}
@@ -0,0 +1,86 @@
+#pragma once
+// BenchCommon, the command line and statistics helpers the benches in Tools share
+// header only, every bench includes it from its own single source file
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/// <Bench>
+/// a bench keeps its defaults in its own Options struct and hands ParseArgs one Flag per option
+/// ParseArgs fails on an unknown flag, on a flag missing its value and on a stray argument,
+/// main then prints the usage line and exits with 1
+/// </Bench>
+namespace Bench {
+    struct Flag {
+        const char* name;
+        std::function<void(const char*)> set;  // gets the value, nullptr for a switch
+        bool takes_value = true;
+    };
+
+    // --name N, values below min are raised to min
+    template <typename T>
+    Flag Number(const char* name, T& out, std::type_identity_t<T> min = std::numeric_limits<T>::lowest()) {
+        static_assert(std::is_integral_v<T>, "Number parses integers");
+        return { name, [&out, min](const char* value) {
+            if constexpr (std::is_signed_v<T>) {
+                out = static_cast<T>(std::max<long long>(min, std::strtoll(value, nullptr, 10)));
+            }
+            else {
+                out = static_cast<T>(std::max<unsigned long long>(min, std::strtoull(value, nullptr, 10)));
+            }
+        } };
+    }
+
+    // --name without a value, sets out
+    inline Flag Switch(const char* name, bool& out) {
+        return { name, [&out](const char*) { out = true; }, false };
+    }
+
+    // arguments that are not flags go to positional, or fail the parse when it is null
+    inline bool ParseArgs(int argc, char** argv, std::initializer_list<Flag> flags,
+        std::vector<std::string>* positional = nullptr) {
+        for (int i = 1; i < argc; ++i) {
+            const Flag* match = nullptr;
+            for (const Flag& flag : flags) {
+                if (std::strcmp(argv[i], flag.name) == 0) {
+                    match = &flag;
+                    break;
+                }
+            }
+            if (!match) {
+                if (!positional || std::strncmp(argv[i], "--", 2) == 0) return false;
+                positional->push_back(argv[i]);
+            }
+            else if (!match->takes_value) {
+                match->set(nullptr);
+            }
+            else if (i + 1 < argc) {
+                match->set(argv[++i]);
+            }
+            else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // print the usage line, returns main's exit code
+    inline int Usage(const char* usage) {
+        std::cerr << "usage: " << usage << "\n";
+        return 1;
+    }
+
+    // value at fraction p of an ascending sorted, non empty sample
+    template <typename T>
+    T Percentile(const std::vector<T>& sorted, double p) {
+        return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()))];
+    }
+}
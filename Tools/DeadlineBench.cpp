@@ -0,0 +1,140 @@
+// DeadlineBench, replays a frame workload and compares deadline misses under DispatchMode::Priority and EarliestDeadline
+// build with the TaskManager and Utilities sources
+//
+// usage: DeadlineBench [--frames N] [--workers N] [--fps N] [--seed N]
+//   --frames   frames replayed per mode (default 300)
+//   --workers  pool size (default one per hardware thread minus the dispatcher)
+//   --fps      frame rate, one batch of tasks is released per frame (default 60)
+//   --seed     seed of the generated frame script, both modes replay the same script (default 1)
+// every frame first queues a few long background jobs due in four frames, then the short frame jobs
+// due half way through the frame, all at the same priority, so Priority mode runs them first come first served
+// a task misses when it finishes after its deadline, late tasks still run (DeadlineMissPolicy::Report)
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+#include "BenchCommon.h"
+#include "../TaskManager/TaskScheduler.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        size_t frames = 300;
+        size_t workers = SchedulerConfig::Default().ResolveWorkers();
+        int fps = 60;
+        uint32_t seed = 1;
+    };
+
+    enum Kind { Frame = 0, Background = 1 };
+
+    struct Job {
+        Kind kind;
+        std::chrono::microseconds cost;
+        std::chrono::microseconds due;  // after the frame start
+    };
+
+    // the same frames for both modes, sized so the pool is busy for about 70% of each frame
+    std::vector<std::vector<Job>> Script(const Options& options) {
+        std::mt19937 rng(options.seed);
+        std::chrono::microseconds frame(1000000 / options.fps);
+        int64_t budget_us = frame.count() * static_cast<int64_t>(options.workers) * 7 / 10;
+        std::uniform_int_distribution<int64_t> frame_cost(100, 600);
+        std::uniform_int_distribution<int64_t> background_cost(1500, 3000);
+
+        std::vector<std::vector<Job>> frames(options.frames);
+        for (auto& jobs : frames) {
+            int64_t used = 0;
+            // background first, it arrives before the frame's own work does
+            while (used < budget_us * 4 / 10) {
+                int64_t cost = background_cost(rng);
+                jobs.push_back({ Background, std::chrono::microseconds(cost), frame * 4 });
+                used += cost;
+            }
+            while (used < budget_us) {
+                int64_t cost = frame_cost(rng);
+                jobs.push_back({ Frame, std::chrono::microseconds(cost), frame / 2 });
+                used += cost;
+            }
+        }
+        return frames;
+    }
+
+    struct Counts {
+        std::atomic<uint64_t> done[2] = {};
+        std::atomic<uint64_t> missed[2] = {};
+        std::atomic<int64_t> worst_late_ns[2] = {};
+    };
+
+    void Replay(DispatchMode mode, const Options& options, const std::vector<std::vector<Job>>& frames, Counts& counts) {
+        SchedulerConfig config;
+        config.workers = options.workers;
+        config.dispatch = mode;
+        config.miss_policy = DeadlineMissPolicy::Report;
+        uint64_t total = 0;
+        {
+            TaskScheduler scheduler(config);
+            std::chrono::microseconds frame(1000000 / options.fps);
+            Clock::time_point start = Clock::now() + frame;
+            for (size_t f = 0; f < frames.size(); ++f) {
+                Clock::time_point frame_start = start + frame * f;
+                std::this_thread::sleep_until(frame_start);
+                for (const Job& job : frames[f]) {
+                    Clock::time_point deadline = frame_start + job.due;
+                    auto task = std::make_shared<Task>([&counts, job, deadline]() {
+                        Clock::time_point until = Clock::now() + job.cost;
+                        while (Clock::now() < until) {}
+                        int64_t late = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - deadline).count();
+                        if (late > 0) {
+                            counts.missed[job.kind].fetch_add(1, std::memory_order_relaxed);
+                            int64_t worst = counts.worst_late_ns[job.kind].load(std::memory_order_relaxed);
+                            while (late > worst && !counts.worst_late_ns[job.kind].compare_exchange_weak(worst, late)) {}
+                        }
+                        counts.done[job.kind].fetch_add(1, std::memory_order_relaxed);
+                    });
+                    task->SetDeadline(deadline, job.cost);
+                    scheduler.AddTask(task);
+                    ++total;
+                }
+            }
+            while (counts.done[Frame].load() + counts.done[Background].load() < total) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+    }
+
+    void Report(const char* name, const Counts& counts) {
+        for (int kind : { Frame, Background }) {
+            uint64_t done = counts.done[kind].load();
+            uint64_t missed = counts.missed[kind].load();
+            std::cout << std::format("{:<18}  {:<10}  {:>7}  {:>7}  {:>7.2f}%  {:>10.2f}\n", name,
+                kind == Frame ? "frame" : "background", done, missed, done ? 100.0 * missed / done : 0.0,
+                static_cast<double>(counts.worst_late_ns[kind].load()) / 1e6);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!Bench::ParseArgs(argc, argv, { Bench::Number("--frames", options.frames, 1), Bench::Number("--workers", options.workers, 1),
+        Bench::Number("--fps", options.fps, 1), Bench::Number("--seed", options.seed) })) {
+        return Bench::Usage("DeadlineBench [--frames N] [--workers N] [--fps N] [--seed N]");
+    }
+
+    std::vector<std::vector<Job>> frames = Script(options);
+    std::cout << std::format("{} frames at {} fps, {} workers, seed {}\n", options.frames, options.fps, options.workers, options.seed);
+    std::cout << std::format("{:<18}  {:<10}  {:>7}  {:>7}  {:>8}  {:>10}\n", "mode", "tasks", "run", "missed", "rate", "worst ms");
+    Counts fifo;
+    Replay(DispatchMode::Priority, options, frames, fifo);
+    Report("Priority (FIFO)", fifo);
+    Counts edf;
+    Replay(DispatchMode::EarliestDeadline, options, frames, edf);
+    Report("EarliestDeadline", edf);
+    return 0;
+}
@@ -0,0 +1,120 @@
+// DequeBench, compares the per-worker WorkStealingDeque with the locked MessageQueue it replaced
+// build with the TaskManager and Utilities sources
+//
+// usage: DequeBench [--items N] [--runs N]
+//   --items  items pushed by the owner per run (default 1000000)
+//   --runs   runs per configuration, the best one is reported (default 5)
+// the owner pushes in batches and pops half of each batch back, thieves take the rest from the other end
+// like idle workers stealing, every item is taken exactly once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "BenchCommon.h"
+#include "../TaskManager/MessageQueue.h"
+#include "../TaskManager/WorkStealingDeque.h"
+#include "../Utilities/HighResClock.h"
+
+namespace {
+    constexpr size_t kBatch = 64;
+
+    struct Options {
+        size_t items = 1000000;
+        size_t runs = 5;
+    };
+
+    // the deque the way a worker uses it: the owner at the bottom, thieves at the top
+    struct DequeSide {
+        WorkStealingDeque<uintptr_t*> deque;
+
+        void push(uintptr_t* item) { deque.push(item); }
+        bool pop() { return deque.pop() != nullptr; }
+        bool steal() { return deque.steal() != nullptr; }
+    };
+
+    // the old per-worker queue, both ends go through the one mutex
+    struct QueueSide {
+        MessageQueue queue;
+
+        void push(uintptr_t* item) {
+            Message msg(MessageType::Task);
+            msg.data = item;
+            queue.push(msg);
+        }
+        bool pop() { return queue.try_pop().has_value(); }
+        bool steal() { return queue.try_pop().has_value(); }
+    };
+
+    // ns per item for one run, from the first push until every item has been taken
+    template <typename Side>
+    double Run(size_t thieves, size_t items) {
+        Side side;
+        std::vector<uintptr_t> storage(kBatch);
+        std::atomic<size_t> taken{ 0 };
+        std::atomic<bool> start{ false };
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < thieves; ++i) {
+            threads.emplace_back([&]() {
+                while (!start.load(std::memory_order_acquire)) std::this_thread::yield();
+                while (taken.load(std::memory_order_relaxed) < items) {
+                    if (side.steal()) taken.fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+        }
+
+        int64_t begin = HighResClock::Now();
+        start.store(true, std::memory_order_release);
+        for (size_t pushed = 0; pushed < items;) {
+            size_t batch = std::min(kBatch, items - pushed);
+            for (size_t i = 0; i < batch; ++i) {
+                side.push(&storage[i]);
+            }
+            pushed += batch;
+            for (size_t i = 0; i < batch / 2; ++i) {
+                if (side.pop()) taken.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        while (taken.load(std::memory_order_relaxed) < items) {
+            if (side.pop()) taken.fetch_add(1, std::memory_order_relaxed);
+        }
+        int64_t end = HighResClock::Now();
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        return static_cast<double>(end - begin) / static_cast<double>(items);
+    }
+
+    template <typename Side>
+    double Best(size_t thieves, const Options& options) {
+        double best = 1e300;
+        for (size_t run = 0; run < options.runs; ++run) {
+            best = std::min(best, Run<Side>(thieves, options.items));
+        }
+        return best;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!Bench::ParseArgs(argc, argv, { Bench::Number("--items", options.items, kBatch), Bench::Number("--runs", options.runs, 1) })) {
+        return Bench::Usage("DequeBench [--items N] [--runs N]");
+    }
+
+    size_t cores = std::max(2u, std::thread::hardware_concurrency());
+    std::vector<size_t> thief_counts = { 0, 1, 3, cores - 1 };
+    std::sort(thief_counts.begin(), thief_counts.end());
+    thief_counts.erase(std::unique(thief_counts.begin(), thief_counts.end()), thief_counts.end());
+
+    std::cout << std::format("{} items per run, best of {}\n", options.items, options.runs);
+    std::cout << std::format("{:>8}  {:>14}  {:>14}  {:>8}\n", "thieves", "deque ns/item", "queue ns/item", "speedup");
+    for (size_t thieves : thief_counts) {
+        double deque = Best<DequeSide>(thieves, options);
+        double queue = Best<QueueSide>(thieves, options);
+        std::cout << std::format("{:>8}  {:>14.1f}  {:>14.1f}  {:>7.2f}x\n", thieves, deque, queue, queue / deque);
+    }
+    return 0;
+}
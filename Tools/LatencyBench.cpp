@@ -0,0 +1,88 @@
+// LatencyBench, measures the time from AddTask until the task starts on a worker
+// build with the TaskManager and Utilities sources
+//
+// usage: LatencyBench [--samples N] [--gap-us N] [--timers N] [--interval-us N]
+//   --samples      tasks submitted per phase (default 5000)
+//   --gap-us       pause between submissions so the workers park in between (default 200)
+//   --timers       periodic tasks running during the second phase (default 8)
+//   --interval-us  interval of those periodic tasks (default 500)
+// the first phase runs with an idle dispatcher, the second with the dispatcher busy on periodic work,
+// regular tasks never pass through the dispatcher so both should show the same distribution
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BenchCommon.h"
+#include "../TaskManager/TaskManager.h"
+#include "../Utilities/HighResClock.h"
+
+namespace {
+    struct Options {
+        size_t samples = 5000;
+        int64_t gap_us = 200;
+        size_t timers = 8;
+        int64_t interval_us = 500;
+    };
+
+    // submit-to-start latency of every sample, in ns
+    std::vector<int64_t> Measure(TaskScheduler& scheduler, const Options& options) {
+        std::vector<int64_t> latency(options.samples);
+        std::atomic<size_t> done{ 0 };
+        for (size_t i = 0; i < options.samples; ++i) {
+            int64_t submitted = HighResClock::Now();
+            scheduler.AddTask(std::make_shared<Task>([&latency, &done, i, submitted]() {
+                latency[i] = HighResClock::Now() - submitted;
+                done.fetch_add(1, std::memory_order_release);
+            }));
+            // spin rather than sleep, a sleep this short overshoots by more than what we measure
+            int64_t until = HighResClock::Now() + options.gap_us * 1000;
+            while (HighResClock::Now() < until) std::this_thread::yield();
+        }
+        while (done.load(std::memory_order_acquire) < options.samples) {
+            std::this_thread::yield();
+        }
+        std::sort(latency.begin(), latency.end());
+        return latency;
+    }
+
+    void Report(const std::string& name, const std::vector<int64_t>& sorted) {
+        auto us = [&sorted](double p) { return static_cast<double>(Bench::Percentile(sorted, p)) / 1e3; };
+        std::cout << std::format("{:<22}  {:>8.1f}  {:>8.1f}  {:>8.1f}  {:>8.1f}  {:>9.1f}\n", name,
+            us(0.0), us(0.5), us(0.9), us(0.99), static_cast<double>(sorted.back()) / 1e3);
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!Bench::ParseArgs(argc, argv, { Bench::Number("--samples", options.samples, 1), Bench::Number("--gap-us", options.gap_us),
+        Bench::Number("--timers", options.timers), Bench::Number("--interval-us", options.interval_us, 1) })) {
+        return Bench::Usage("LatencyBench [--samples N] [--gap-us N] [--timers N] [--interval-us N]");
+    }
+
+    std::shared_ptr<TaskScheduler> scheduler = TaskManager::Scheduler();
+    std::cout << std::format("{} samples per phase, {} us apart, latency in us\n", options.samples, options.gap_us);
+    std::cout << std::format("{:<22}  {:>8}  {:>8}  {:>8}  {:>8}  {:>9}\n", "dispatcher", "min", "p50", "p90", "p99", "max");
+    Report("idle", Measure(*scheduler, options));
+
+    // a little work per tick so the dispatcher keeps waking up and queueing runs
+    std::atomic<uint64_t> ticks{ 0 };
+    for (size_t i = 0; i < options.timers; ++i) {
+        scheduler->ScheduleTask(std::make_shared<Task>([&ticks]() {
+            int64_t until = HighResClock::Now() + 20000;
+            while (HighResClock::Now() < until) {}
+            ticks.fetch_add(1, std::memory_order_relaxed);
+        }), std::chrono::microseconds(options.interval_us));
+    }
+    std::vector<int64_t> busy = Measure(*scheduler, options);
+    Report(std::format("{} timers @ {} us", options.timers, options.interval_us), busy);
+    std::cout << std::format("periodic runs during the second phase: {}\n", ticks.load());
+
+    scheduler->StopAll();
+    return 0;
+}
@@ -0,0 +1,75 @@
+// LogBench, measures what a log call costs the calling thread in sync and in async mode
+// build with Utilities/Log.cpp and Utilities/BinaryLogSink.cpp, it writes log.txt into the working directory
+//
+// usage: LogBench [--lines N] [--threads N]
+//   --lines    info lines logged per thread (default 100000)
+//   --threads  threads logging at once (default 4)
+// every call is timed on its own, the drain column is the Flush that follows the last call
+// in async mode, the time the backend still needed to get everything into the file
+#include <algorithm>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <source_location>
+#include <thread>
+#include <vector>
+#include "BenchCommon.h"
+#include "../Utilities/HighResClock.h"
+#include "../Utilities/Log.h"
+
+namespace {
+    struct Options {
+        size_t lines = 100000;
+        size_t threads = 4;
+    };
+
+    void Run(Log_Mode mode, const Options& options) {
+        Log log(mode);
+        std::vector<std::vector<int64_t>> calls(options.threads, std::vector<int64_t>(options.lines));
+        std::vector<std::thread> threads;
+        int64_t begin = HighResClock::Now();
+        for (size_t t = 0; t < options.threads; ++t) {
+            threads.emplace_back([&log, &calls, &options, t]() {
+                std::vector<int64_t>& mine = calls[t];
+                for (size_t i = 0; i < options.lines; ++i) {
+                    int64_t start = HighResClock::Now();
+                    log.Write(Log_Level::Info, std::source_location::current(), "frame {} thread {} took {:.3f} ms", i, t, 16.6);
+                    mine[i] = HighResClock::Now() - start;
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        int64_t logged = HighResClock::Now();
+        log.Flush();
+        int64_t flushed = HighResClock::Now();
+
+        std::vector<int64_t> all;
+        all.reserve(options.threads * options.lines);
+        for (const auto& mine : calls) {
+            all.insert(all.end(), mine.begin(), mine.end());
+        }
+        std::sort(all.begin(), all.end());
+        double mean = 0.0;
+        for (int64_t ns : all) mean += static_cast<double>(ns);
+        mean /= static_cast<double>(all.size());
+
+        std::cout << std::format("{:<6}  {:>8.0f}  {:>8}  {:>8}  {:>10}  {:>9.1f}  {:>9.1f}\n",
+            mode == Log_Mode::Sync ? "sync" : "async", mean, Bench::Percentile(all, 0.5), Bench::Percentile(all, 0.99),
+            all.back(), static_cast<double>(logged - begin) / 1e6, static_cast<double>(flushed - logged) / 1e6);
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!Bench::ParseArgs(argc, argv, { Bench::Number("--lines", options.lines, 1), Bench::Number("--threads", options.threads, 1) })) {
+        return Bench::Usage("LogBench [--lines N] [--threads N]");
+    }
+
+    std::cout << std::format("{} threads x {} lines, per call ns, wall and drain in ms\n", options.threads, options.lines);
+    std::cout << std::format("{:<6}  {:>8}  {:>8}  {:>8}  {:>10}  {:>9}  {:>9}\n", "mode", "mean", "p50", "p99", "max", "wall", "drain");
+    Run(Log_Mode::Sync, options);
+    Run(Log_Mode::Async, options);
+    return 0;
+}
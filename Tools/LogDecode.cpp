@@ -0,0 +1,186 @@
+// LogDecode, converts binary log segments (log.N.bin) written by BinaryLogSink back to text
+// build standalone: it only needs Utilities/BinaryLogFormat.h
+//
+// usage: LogDecode [--level D|I|W|E] [--thread N] [--from SECONDS] [--to SECONDS] log.0.bin [log.1.bin ...]
+//   --level   lowest level to print
+//   --thread  only records from this thread index
+//   --from    only records at or after this time, seconds since the epoch
+//   --to      only records before this time, seconds since the epoch
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../Utilities/BinaryLogFormat.h"
+
+namespace {
+    struct Filter {
+        int min_rank = 0;
+        std::optional<uint32_t> thread;
+        int64_t from_ns = INT64_MIN;
+        int64_t to_ns = INT64_MAX;
+    };
+
+    int Rank(char level) {
+        switch (level) {
+        case 'D': return 0;
+        case 'I': return 1;
+        case 'W': return 2;
+        case 'E': return 3;
+        }
+        return 3;
+    }
+
+    std::string_view LevelString(char level) {
+        switch (level) {
+        case 'D': return "DEBUG: ";
+        case 'I': return "INFO: ";
+        case 'W': return "WARNING: ";
+        case 'E': return "ERROR: ";
+        }
+        return "?: ";
+    }
+
+    struct Segment {
+        std::string path;
+        uint32_t index = 0;
+        int64_t run_ns = 0;
+        std::vector<char> bytes;
+    };
+
+    bool Load(const std::string& path, Segment& segment) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            std::cerr << "cannot open " << path << "\n";
+            return false;
+        }
+        segment.path = path;
+        segment.bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+        BinaryLog::SegmentHeader header;
+        if (segment.bytes.size() < sizeof(header)) {
+            std::cerr << path << ": too short for a log segment\n";
+            return false;
+        }
+        std::memcpy(&header, segment.bytes.data(), sizeof(header));
+        if (std::memcmp(header.magic, BinaryLog::kMagic, sizeof(header.magic)) != 0 || header.version != BinaryLog::kVersion) {
+            std::cerr << path << ": not a version " << BinaryLog::kVersion << " binary log segment\n";
+            return false;
+        }
+        segment.index = header.index;
+        segment.run_ns = header.run_ns;
+        return true;
+    }
+
+    // print every record of the segment that passes the filter, returns how many were printed
+    size_t Decode(const Segment& segment, const Filter& filter, std::string& out) {
+        size_t printed = 0;
+        size_t offset = sizeof(BinaryLog::SegmentHeader);
+        while (offset + sizeof(BinaryLog::RecordHeader) <= segment.bytes.size()) {
+            BinaryLog::RecordHeader header;
+            std::memcpy(&header, segment.bytes.data() + offset, sizeof(header));
+            if (header.size == 0) break;  // end of the written part
+            size_t strings = size_t(header.file_bytes) + header.function_bytes + header.message_bytes;
+            if (header.size < sizeof(header) + strings || offset + header.size > segment.bytes.size()) {
+                std::cerr << segment.path << ": corrupt record at offset " << offset << "\n";
+                break;
+            }
+
+            bool pass = Rank(header.level) >= filter.min_rank
+                && (!filter.thread || *filter.thread == header.thread)
+                && header.timestamp_ns >= filter.from_ns && header.timestamp_ns < filter.to_ns;
+            if (pass) {
+                const char* text = segment.bytes.data() + offset + sizeof(header);
+                std::string_view file(text, header.file_bytes);
+                std::string_view function(text + header.file_bytes, header.function_bytes);
+                std::string_view message(text + header.file_bytes + header.function_bytes, header.message_bytes);
+                std::chrono::sys_time<std::chrono::nanoseconds> tp{ std::chrono::nanoseconds(header.timestamp_ns) };
+                std::format_to(std::back_inserter(out), "[{}] {:%F %T} UTC | T{} | {}:{}:{} | {}\n",
+                    LevelString(header.level), tp, header.thread, file, function, header.line, message);
+                ++printed;
+            }
+            offset += header.size;
+        }
+        return printed;
+    }
+
+    int64_t SecondsToNs(const char* text) {
+        return static_cast<int64_t>(std::strtod(text, nullptr) * 1e9);
+    }
+
+    void Usage() {
+        std::cerr << "usage: LogDecode [--level D|I|W|E] [--thread N] [--from SECONDS] [--to SECONDS] log.0.bin [log.1.bin ...]\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    Filter filter;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--level" && has_value) {
+            filter.min_rank = Rank(argv[++i][0]);
+        }
+        else if (arg == "--thread" && has_value) {
+            filter.thread = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--from" && has_value) {
+            filter.from_ns = SecondsToNs(argv[++i]);
+        }
+        else if (arg == "--to" && has_value) {
+            filter.to_ns = SecondsToNs(argv[++i]);
+        }
+        else if (arg.starts_with("--")) {
+            Usage();
+            return 2;
+        }
+        else {
+            paths.emplace_back(arg);
+        }
+    }
+    if (paths.empty()) {
+        Usage();
+        return 2;
+    }
+
+    std::vector<Segment> segments;
+    for (const auto& path : paths) {
+        Segment segment;
+        if (Load(path, segment)) {
+            segments.push_back(std::move(segment));
+        }
+    }
+    // segments in log order whatever order the shell listed them in
+    std::sort(segments.begin(), segments.end(), [](const Segment& a, const Segment& b) { return a.index < b.index; });
+    // the sink only truncates the segments it writes, a longer earlier run leaves its higher ones
+    // behind. keep the run of segment 0, or of the newest segment when 0 was not given
+    if (!segments.empty()) {
+        int64_t run = segments.front().run_ns;
+        if (segments.front().index != 0) {
+            run = std::max_element(segments.begin(), segments.end(),
+                [](const Segment& a, const Segment& b) { return a.run_ns < b.run_ns; })->run_ns;
+        }
+        std::erase_if(segments, [run](const Segment& segment) {
+            if (segment.run_ns == run) return false;
+            std::cerr << segment.path << ": left over from an earlier run, skipped\n";
+            return true;
+        });
+    }
+
+    std::string out;
+    for (const auto& segment : segments) {
+        Decode(segment, filter, out);
+        std::cout << out;
+        out.clear();
+    }
+    return segments.empty() ? 1 : 0;
+}
@@ -0,0 +1,84 @@
+// PooledTaskBench, compares pooled tasks from Spawn with heap allocated shared_ptr tasks from AddTask
+// build with the TaskManager and Utilities sources
+//
+// usage: PooledTaskBench [--tasks N] [--runs N]
+//   --tasks  empty tasks per run (default 200000)
+//   --runs   runs per mode, the best one is reported (default 5)
+// every task is created inside the timed region, a run ends when the last task has finished
+// tasks are submitted from the main thread and from a worker, which pushes onto its own deque
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include "BenchCommon.h"
+#include "../TaskManager/TaskManager.h"
+#include "../Utilities/HighResClock.h"
+
+namespace {
+    struct Options {
+        size_t tasks = 200000;
+        size_t runs = 5;
+    };
+
+    void Submit(TaskScheduler& scheduler, bool pooled, size_t count, std::atomic<size_t>& done) {
+        for (size_t i = 0; i < count; ++i) {
+            if (pooled) {
+                scheduler.Spawn([&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+            }
+            else {
+                scheduler.AddTask(std::make_shared<Task>([&done]() { done.fetch_add(1, std::memory_order_relaxed); }));
+            }
+        }
+    }
+
+    // ns per task from the first submit until the last task has finished
+    double Run(TaskScheduler& scheduler, bool pooled, bool from_worker, size_t count) {
+        std::atomic<size_t> done{ 0 };
+        int64_t begin = HighResClock::Now();
+        if (from_worker) {
+            // the submitting task itself is not counted
+            scheduler.Spawn([&scheduler, pooled, count, &done]() { Submit(scheduler, pooled, count, done); });
+        }
+        else {
+            Submit(scheduler, pooled, count, done);
+        }
+        while (done.load(std::memory_order_relaxed) < count) {
+            std::this_thread::yield();
+        }
+        return static_cast<double>(HighResClock::Now() - begin) / count;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!Bench::ParseArgs(argc, argv, { Bench::Number("--tasks", options.tasks, 1), Bench::Number("--runs", options.runs, 1) })) {
+        return Bench::Usage("PooledTaskBench [--tasks N] [--runs N]");
+    }
+
+    std::shared_ptr<TaskScheduler> scheduler = TaskManager::Scheduler();
+    struct Row { const char* name; bool pooled; bool from_worker; double best; };
+    Row rows[] = {
+        { "AddTask(shared_ptr)  main", false, false, 1e300 },
+        { "Spawn                main", true, false, 1e300 },
+        { "AddTask(shared_ptr)  worker", false, true, 1e300 },
+        { "Spawn                worker", true, true, 1e300 },
+    };
+    // the rows take turns run by run, a pool still warming up or a busy core is not charged to one allocator
+    for (size_t run = 0; run < options.runs; ++run) {
+        for (Row& row : rows) {
+            row.best = std::min(row.best, Run(*scheduler, row.pooled, row.from_worker, options.tasks));
+        }
+    }
+
+    std::cout << std::format("{} empty tasks per run, best of {}\n", options.tasks, options.runs);
+    std::cout << std::format("{:<28}  {:>8}  {:>12}\n", "submit", "ns/task", "tasks/s");
+    for (const Row& row : rows) {
+        std::cout << std::format("{:<28}  {:>8.1f}  {:>12.0f}\n", row.name, row.best, 1e9 / row.best);
+    }
+
+    scheduler->StopAll();
+    return 0;
+}
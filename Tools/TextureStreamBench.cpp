@@ -0,0 +1,112 @@
+// TextureStreamBench, streams textures into a window and reports the frame time spikes it causes
+// build with the Renderer/Core, TaskManager and Utilities sources, it defines the stb implementation itself
+//
+// usage: TextureStreamBench [--sync] [--count N] [--per-frame N] image [image ...]
+//   --sync       load with the blocking GLTexture2D(path) constructor instead of GLTexture2D::LoadAsync
+//   --count      textures to load, the images are cycled (default 300)
+//   --per-frame  loads started per frame (default 4)
+// a spike is a frame that took more than twice the median
+#include <algorithm>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#include "BenchCommon.h"
+#include "../Renderer/Core/GLTexture2D.h"
+#include "../Renderer/Core/TextureStreamer.h"
+#include "../TaskManager/TaskManager.h"
+#include "../Utilities/HighResClock.h"
+
+namespace {
+    struct Options {
+        bool sync = false;
+        size_t count = 300;
+        size_t per_frame = 4;
+        std::vector<std::string> images;
+    };
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!Bench::ParseArgs(argc, argv, { Bench::Switch("--sync", options.sync), Bench::Number("--count", options.count),
+        Bench::Number("--per-frame", options.per_frame, 1) }, &options.images) || options.images.empty()) {
+        return Bench::Usage("TextureStreamBench [--sync] [--count N] [--per-frame N] image [image ...]");
+    }
+
+    if (!glfwInit()) {
+        std::cerr << "Failed to initialize GLFW\n";
+        return 1;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    GLFWwindow* window = glfwCreateWindow(640, 480, "TextureStreamBench", nullptr, nullptr);
+    if (!window) {
+        std::cerr << "Failed to create GLFW window\n";
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);  // measure our own frame cost, not the vsync wait
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        std::cerr << "Failed to initialize GLAD\n";
+        return 1;
+    }
+
+    std::shared_ptr<TaskScheduler> scheduler = TaskManager::Scheduler();
+    std::vector<std::shared_ptr<GLTexture2D>> textures;
+    textures.reserve(options.count);
+    std::vector<double> frame_ms;
+    int64_t start = HighResClock::Now();
+    int64_t last = start;
+
+    while (!glfwWindowShouldClose(window)) {
+        TextureStreamer::Get()->Update();
+        scheduler->DrainMainThread(std::chrono::milliseconds(2));
+
+        for (size_t i = 0; i < options.per_frame && textures.size() < options.count; ++i) {
+            const std::string& path = options.images[textures.size() % options.images.size()];
+            textures.push_back(options.sync ? std::make_shared<GLTexture2D>(path) : GLTexture2D::LoadAsync(path));
+        }
+
+        glClearColor(0.45f, 0.55f, 0.60f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        if (!textures.empty()) {
+            textures.back()->bind(0);  // touch the newest one like a draw would
+        }
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+
+        int64_t now = HighResClock::Now();
+        frame_ms.push_back(static_cast<double>(now - last) / 1e6);
+        last = now;
+
+        if (textures.size() == options.count && TextureStreamer::Get()->Pending() == 0) {
+            break;
+        }
+    }
+    glFinish();
+    double total_ms = static_cast<double>(HighResClock::Now() - start) / 1e6;
+
+    std::vector<double> sorted = frame_ms;
+    std::sort(sorted.begin(), sorted.end());
+    double median = Bench::Percentile(sorted, 0.5);
+    size_t spikes = std::count_if(frame_ms.begin(), frame_ms.end(), [median](double ms) { return ms > 2.0 * median; });
+    std::cout << std::format("{} textures, {} mode, {} frames in {:.1f} ms\n",
+        textures.size(), options.sync ? "sync" : "async", frame_ms.size(), total_ms);
+    std::cout << std::format("frame ms: p50 {:.3f}  p99 {:.3f}  max {:.3f}  spikes (>2x p50) {}\n",
+        median, Bench::Percentile(sorted, 0.99), sorted.back(), spikes);
+
+    textures.clear();
+    scheduler->StopAll();
+    TextureStreamer::Shutdown();
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/// <BinaryLogFormat>
+/// on disk layout of the binary log, shared by BinaryLogSink and the LogDecode tool
+/// a log is a run of segment files, each starts with a SegmentHeader followed by records
+/// every record is a RecordHeader then the file name, function name and message bytes, padded to 8
+/// a record size of 0 ends the segment, the unused tail of a pre-sized segment is all zero
+/// run_ns tells the segments of this log from those a longer earlier run left behind
+/// </BinaryLogFormat>
+namespace BinaryLog {
+    constexpr char kMagic[8] = { 'T', 'S', 'K', 'L', 'O', 'G', 'B', '1' };
+    constexpr uint32_t kVersion = 1;
+
+    struct SegmentHeader {
+        char magic[8];        // kMagic
+        uint32_t version;     // kVersion
+        uint32_t index;       // position of this segment in the log, 0 based
+        int64_t created_ns;   // system clock, ns since the epoch
+        int64_t run_ns;       // created_ns of segment 0, the same in every segment of one log
+        uint64_t reserved[4];
+    };
+    static_assert(sizeof(SegmentHeader) == 64, "SegmentHeader layout changed");
+
+    struct RecordHeader {
+        uint32_t size;            // whole record in bytes including padding, 0 ends the segment
+        char level;               // Log_Level letter, D I W or E
+        uint8_t reserved;
+        uint16_t file_bytes;
+        uint32_t thread;          // small per process thread index
+        uint32_t line;
+        int64_t timestamp_ns;     // system clock, ns since the epoch
+        uint16_t function_bytes;
+        uint16_t reserved2;
+        uint32_t message_bytes;
+    };
+    static_assert(sizeof(RecordHeader) == 32, "RecordHeader layout changed");
+
+    // bytes a record with these strings occupies
+    constexpr size_t RecordSize(size_t file_bytes, size_t function_bytes, size_t message_bytes) {
+        return (sizeof(RecordHeader) + file_bytes + function_bytes + message_bytes + 7) & ~size_t(7);
+    }
+}
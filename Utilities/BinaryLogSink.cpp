@@ -0,0 +1,149 @@
+#include "BinaryLogSink.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+BinaryLogSink::BinaryLogSink(std::string base_path, size_t segment_bytes)
+    : base_path_(std::move(base_path)),
+      segment_bytes_(segment_bytes < (size_t(1) << 16) ? (size_t(1) << 16) : segment_bytes) {
+    OpenSegment(0);
+}
+
+BinaryLogSink::~BinaryLogSink() {
+    CloseSegment(true);
+}
+
+void BinaryLogSink::Append(char level, uint32_t thread, int64_t timestamp_ns, std::string_view file,
+    std::string_view function, uint32_t line, std::string_view message) {
+    if (!base_) return;
+
+    // keep any one record well inside a segment
+    file = file.substr(0, UINT16_MAX);
+    function = function.substr(0, UINT16_MAX);
+    message = message.substr(0, segment_bytes_ / 2);
+
+    size_t size = BinaryLog::RecordSize(file.size(), function.size(), message.size());
+    if (used_ + size > segment_bytes_) {
+        // the zero tail ends this segment for the decoder
+        CloseSegment(false);
+        if (!OpenSegment(index_ + 1)) return;
+    }
+
+    BinaryLog::RecordHeader header{};
+    header.size = static_cast<uint32_t>(size);
+    header.level = level;
+    header.file_bytes = static_cast<uint16_t>(file.size());
+    header.thread = thread;
+    header.line = line;
+    header.timestamp_ns = timestamp_ns;
+    header.function_bytes = static_cast<uint16_t>(function.size());
+    header.message_bytes = static_cast<uint32_t>(message.size());
+
+    std::byte* out = base_ + used_;
+    std::memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+    std::memcpy(out, file.data(), file.size());
+    out += file.size();
+    std::memcpy(out, function.data(), function.size());
+    out += function.size();
+    std::memcpy(out, message.data(), message.size());
+    used_ += size;
+}
+
+void BinaryLogSink::Flush() {
+    if (!base_) return;
+#ifdef _WIN32
+    FlushViewOfFile(base_, used_);
+#else
+    msync(base_, used_, MS_ASYNC);
+#endif
+}
+
+bool BinaryLogSink::OpenSegment(uint32_t index) {
+    std::string path = base_path_ + "." + std::to_string(index) + ".bin";
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+        CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cerr << "Failed to open " << path << " for writing!" << std::endl;
+        return false;
+    }
+    LARGE_INTEGER size;
+    size.QuadPart = static_cast<LONGLONG>(segment_bytes_);
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, size.HighPart, size.LowPart, nullptr);
+    void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, segment_bytes_) : nullptr;
+    if (!view) {
+        std::cerr << "Failed to map " << path << std::endl;
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    file_ = file;
+    mapping_ = mapping;
+#else
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "Failed to open " << path << " for writing!" << std::endl;
+        return false;
+    }
+    void* view = MAP_FAILED;
+    if (::ftruncate(fd, static_cast<off_t>(segment_bytes_)) == 0) {
+        view = ::mmap(nullptr, segment_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (view == MAP_FAILED) {
+        std::cerr << "Failed to map " << path << std::endl;
+        ::close(fd);
+        return false;
+    }
+    fd_ = fd;
+#endif
+    base_ = static_cast<std::byte*>(view);
+    index_ = index;
+
+    BinaryLog::SegmentHeader header{};
+    std::memcpy(header.magic, BinaryLog::kMagic, sizeof(header.magic));
+    header.version = BinaryLog::kVersion;
+    header.index = index;
+    header.created_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    if (index == 0) {
+        run_ns_ = header.created_ns;
+    }
+    header.run_ns = run_ns_;
+    std::memcpy(base_, &header, sizeof(header));
+    used_ = sizeof(header);
+    return true;
+}
+
+void BinaryLogSink::CloseSegment(bool trim) {
+    if (!base_) return;
+#ifdef _WIN32
+    UnmapViewOfFile(base_);
+    CloseHandle(static_cast<HANDLE>(mapping_));
+    if (trim) {
+        LARGE_INTEGER end;
+        end.QuadPart = static_cast<LONGLONG>(used_);
+        SetFilePointerEx(static_cast<HANDLE>(file_), end, nullptr, FILE_BEGIN);
+        SetEndOfFile(static_cast<HANDLE>(file_));
+    }
+    CloseHandle(static_cast<HANDLE>(file_));
+    file_ = nullptr;
+    mapping_ = nullptr;
+#else
+    ::munmap(base_, segment_bytes_);
+    if (trim) {
+        (void)::ftruncate(fd_, static_cast<off_t>(used_));
+    }
+    ::close(fd_);
+    fd_ = -1;
+#endif
+    base_ = nullptr;
+    used_ = 0;
+}
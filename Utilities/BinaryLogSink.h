@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "BinaryLogFormat.h"
+
+/// <BinaryLogSink>
+/// appends BinaryLogFormat records to memory mapped, pre-sized segment files (base.0.bin, base.1.bin, ...)
+/// appending is a memcpy into the mapping, the only syscalls are mapping the next segment and Flush
+/// not thread safe, the Log backend is its only writer
+/// </BinaryLogSink>
+class BinaryLogSink {
+public:
+    // Constructor, maps the first segment
+    explicit BinaryLogSink(std::string base_path = "log", size_t segment_bytes = size_t(64) << 20);
+    BinaryLogSink(const BinaryLogSink& other) = delete;
+    BinaryLogSink& operator=(const BinaryLogSink& other) = delete;
+    // Destructor, unmaps and trims the last segment
+    ~BinaryLogSink();
+
+    bool IsOpen() const { return base_ != nullptr; }
+    // append one record, rolls over to a new segment when the current one is full
+    void Append(char level, uint32_t thread, int64_t timestamp_ns, std::string_view file,
+        std::string_view function, uint32_t line, std::string_view message);
+    // ask the OS to start writing the dirty pages back, does not wait for them
+    void Flush();
+
+private:
+    bool OpenSegment(uint32_t index);
+    // unmap the current segment, trim it to the bytes used when trim is set
+    void CloseSegment(bool trim);
+
+    std::string base_path_;
+    size_t segment_bytes_;
+    uint32_t index_ = 0;            // current segment
+    int64_t run_ns_ = 0;            // written into every segment header, see SegmentHeader::run_ns
+    std::byte* base_ = nullptr;     // mapping of the current segment
+    size_t used_ = 0;               // bytes written into the current segment
+#ifdef _WIN32
+    void* file_ = nullptr;          // HANDLE
+    void* mapping_ = nullptr;       // HANDLE
+#else
+    int fd_ = -1;
+#endif
+};
@@ -1,46 +1,23 @@
 #include "Clock.h"
     // Default constructor - Starts with the clock paused
     Clock::Clock()
-        : m_start_(std::chrono::steady_clock::now()),
-        m_end_(m_start_),
-        m_duration_(0),  // Start with no accumulated duration
-        m_paused_(true) { // Start in paused state
+        : m_state_(Pack(0, true)) { // Start in paused state with no accumulated duration
     }
 
     // Copy constructor - Keeps the clock paused
     Clock::Clock(const Clock& other)
-        : m_start_(other.m_start_),
-        m_end_(other.m_end_),
-        m_duration_(other.m_duration_),
-        m_paused_(true) { // Copy constructor keeps the clock paused
+        : m_state_(Pack(other.elapsed_ns(), true)) {
     }
 
-    // Move constructor - Keeps the clock paused after moving
+    // Move constructor - Keeps the pause state after moving
     Clock::Clock(Clock&& other) noexcept
-        : m_start_(std::move(other.m_start_)),
-        m_end_(std::move(other.m_end_)),
-        m_duration_(other.m_duration_),  // Move the duration
-        m_paused_(other.m_paused_) {     // Move the pause state
-        other.m_duration_ = std::chrono::steady_clock::duration::zero();
-        other.m_paused_ = true;
-        other.m_start_ = std::chrono::steady_clock::time_point();
-        other.m_end_ = std::chrono::steady_clock::time_point();
+        : m_state_(other.m_state_.exchange(Pack(0, true), std::memory_order_acq_rel)) {
     }
 
     Clock& Clock::operator=(Clock&& other) noexcept {
         if (this != &other) {
-            std::lock_guard<std::mutex> lock(timer_mutex_);
-
-            m_start_ = std::move(other.m_start_);
-            m_end_ = std::move(other.m_end_);
-            m_duration_ = other.m_duration_;
-            m_paused_ = other.m_paused_;
-
             // Reset the moved-from object to a valid state
-            other.m_duration_ = std::chrono::steady_clock::duration::zero();
-            other.m_paused_ = true;
-            other.m_start_ = std::chrono::steady_clock::time_point();
-            other.m_end_ = std::chrono::steady_clock::time_point();
+            m_state_.store(other.m_state_.exchange(Pack(0, true), std::memory_order_acq_rel), std::memory_order_release);
         }
         return *this;
     }
@@ -48,11 +25,8 @@
     // Copy assignment operator
     Clock& Clock::operator=(const Clock& other) {
         if (this != &other) {
-            std::lock_guard<std::mutex> lock(timer_mutex_);
-            m_start_ = other.m_start_;
-            m_end_ = other.m_end_;
-            m_duration_ = other.m_duration_;
-            m_paused_ = other.m_paused_;
+            int64_t state = other.m_state_.load(std::memory_order_acquire);
+            m_state_.store(state, std::memory_order_release);
         }
         return *this;
     }
@@ -60,58 +34,64 @@
     // Destructor
     Clock::~Clock() {}
 
-   void Clock::stop() {
-        std::lock_guard<std::mutex> lock(timer_mutex_);
-        if (!m_paused_) {
-            m_end_ = std::chrono::steady_clock::now();
-            auto time_elapsed = m_end_ - m_start_;
-            m_duration_ += time_elapsed;
-            m_paused_ = true;
+    std::string Clock::to_string() const {
+        long long ms = elapsed_ms();
+        std::ostringstream out;
+        out << std::setfill('0') << std::setw(2) << ms / 3600000 << ':'
+            << std::setw(2) << ms / 60000 % 60 << ':'
+            << std::setw(2) << ms / 1000 % 60 << '.'
+            << std::setw(3) << ms % 1000;
+        return out.str();
+    }
 
-            // Optionally reset m_duration if you want to clear the accumulated time on each stop
-            // m_duration = std::chrono::high_resolution_clock::duration::zero();
+   void Clock::stop() {
+        int64_t state = m_state_.load(std::memory_order_relaxed);
+        while (!(state & kPaused)) {
+            int64_t accumulated = HighResClock::Now() - Unpack(state);
+            if (m_state_.compare_exchange_weak(state, Pack(accumulated, true), std::memory_order_acq_rel)) {
+                return;
+            }
         }
     }
-    // Resume the clock (continue from the last start time without resetting start)
+    // Resume the clock (continue from the accumulated time)
     void Clock::resume() {
-        std::lock_guard<std::mutex> lock(timer_mutex_);
-        if (m_paused_) {
-            m_start_ = std::chrono::steady_clock::now() - (m_end_ - m_start_); // Calculate time difference
-            m_paused_ = false;
+        int64_t state = m_state_.load(std::memory_order_relaxed);
+        while (state & kPaused) {
+            int64_t base = HighResClock::Now() - Unpack(state);
+            if (m_state_.compare_exchange_weak(state, Pack(base, false), std::memory_order_acq_rel)) {
+                return;
+            }
         }
     }
 
-    // Start the clock (begin measuring time)
+    // Start the clock (begin measuring time), adds to the accumulated time like resume
     void Clock::start() {
-        std::lock_guard<std::mutex> lock(timer_mutex_);
-        if (m_paused_) {
-            m_start_ = std::chrono::steady_clock::now();
-            m_end_ = m_start_; // Ensure m_end is reset
-            m_paused_ = false;
-        }
+        resume();
     }
 
     // Reset the clock (clears the accumulated time)
     void Clock::reset() {
-        std::lock_guard<std::mutex> lock(timer_mutex_);
-        m_end_ = std::chrono::steady_clock::now();
-        m_start_ = m_end_;
-        m_duration_ = std::chrono::steady_clock::duration::zero();
-        m_paused_ = true;
+        m_state_.store(Pack(0, true), std::memory_order_release);
     }
 
     // Get the elapsed time in milliseconds
     long long Clock::elapsed_ms() const {
-        std::lock_guard<std::mutex> lock(timer_mutex_);
+        return elapsed_ns() / 1000000;
+    }
 
-        if (m_paused_) {
-            return std::chrono::duration_cast<std::chrono::milliseconds>(m_duration_).count();
-        }
-        else {
-            auto now = std::chrono::steady_clock::now();
-            auto total_elapsed = m_duration_ + (now - m_start_);
-            return std::chrono::duration_cast<std::chrono::milliseconds>(total_elapsed).count();
-        }
+    int64_t Clock::elapsed_ns() const {
+        return Elapsed(m_state_.load(std::memory_order_acquire));
+    }
+
+    bool Clock::paused() const {
+        return (m_state_.load(std::memory_order_relaxed) & kPaused) != 0;
     }
 
+    int64_t Clock::Elapsed(int64_t state) {
+        if (state & kPaused) {
+            return Unpack(state);
+        }
+        int64_t elapsed = HighResClock::Now() - Unpack(state);
+        return elapsed > 0 ? elapsed : 0;
+    }
 
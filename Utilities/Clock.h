@@ -1,20 +1,29 @@
 #pragma once
+#include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <sstream>
 #include <iomanip> // For formatting output
-#include <mutex>
+#include <utility>
+#include "HighResClock.h"
 
+/// <Clock>
+/// stopwatch that accumulates the time between start/resume and stop
+/// the whole state is one atomic word, the paused flag in bit 0 and in the bits above either the
+/// accumulated nanoseconds while paused or HighResClock::Now() minus the accumulated time while running,
+/// so elapsed_ns is a single load and never blocks or writes, the controls update it with a CAS
+/// </Clock>
 class Clock {
 public:
     // Default constructor - Starts with the clock paused
     Clock();
     // Destructor
     ~Clock();
-    // Copy constructor - Keeps the clock paused
+    // Copy constructor - Keeps the clock paused at the time elapsed so far
     Clock(const Clock& other);
-    // Move constructor - Keeps the clock paused after moving
+    // Move constructor - Keeps the pause state, the moved from clock is reset
     Clock(Clock&& other) noexcept;
     // Move assignment operator
     Clock& operator=(Clock&& other) noexcept;
@@ -32,11 +41,41 @@ public:
     void reset();
     // Get the elapsed time in milliseconds
     long long elapsed_ms() const;
+    // Get the elapsed time in nanoseconds
+    int64_t elapsed_ns() const;
+    // return if the clock is stopped
+    bool paused() const;
 
 private:
-    std::chrono::time_point<std::chrono::steady_clock> m_start_; // start timepoint
-    std::chrono::time_point<std::chrono::steady_clock> m_end_;  // end timepoint
-    std::chrono::steady_clock::duration m_duration_;           // Using high_resolution_clock::duration for simplicity
-    bool m_paused_;                                           // clock timer pause flag
-    mutable std::mutex timer_mutex_;                         // Mutex for thread-safety
+    static constexpr int64_t kPaused = 1;
+
+    static int64_t Pack(int64_t ns, bool paused) { return (ns << 1) | (paused ? kPaused : 0); }
+    static int64_t Unpack(int64_t state) { return state >> 1; }
+    static int64_t Elapsed(int64_t state);
+
+    std::atomic<int64_t> m_state_; // accumulated ns (paused) or Now() - accumulated (running), paused flag in bit 0
+};
+
+/// <ScopedTimer>
+/// calls on_done with the nanoseconds it lived, for timing a block or a task
+/// ScopedTimer timer([&](int64_t ns) { total_ns.fetch_add(ns, std::memory_order_relaxed); });
+/// </ScopedTimer>
+template <typename Fn>
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Fn on_done)
+        : on_done_(std::move(on_done)), start_ns_(HighResClock::Now()) {
+    }
+    ScopedTimer(const ScopedTimer& other) = delete;
+    ScopedTimer& operator=(const ScopedTimer& other) = delete;
+    ~ScopedTimer() {
+        on_done_(elapsed_ns());
+    }
+
+    // nanoseconds since construction
+    int64_t elapsed_ns() const { return HighResClock::Now() - start_ns_; }
+
+private:
+    Fn on_done_;
+    int64_t start_ns_;
 };
\ No newline at end of file
@@ -1,8 +1,6 @@
 #pragma once
 #include <string>
-#include <iomanip>
-#include <sstream>
-#include <random>
+#include "EntityID.h"
 
 class Entity {
 public:
@@ -12,17 +10,17 @@ public:
     Entity(const Entity& in) = delete;
     //destructor 
     virtual ~Entity() = default;
-    //return the id as type uuid
-    virtual std::string GetID() const;
+    //return the compact id
+    virtual EntityID GetID() const;
+    //return the id formatted as hex, allocates so keep it off hot paths
+    std::string GetIDString() const;
     //equality/inequality check on ids
     bool operator==(const Entity& other) const;
     bool operator!=(const Entity& other) const;
 protected:
     // the object id
-    std::string objectID;  // UUID object as ID
+    EntityID objectID;  // 64 bit, assigned in the constructor
 private:
     // set the id of the object
-    virtual void SetID(const std::string& id);
-    // generate id
-    std::string GenerateUUID();
+    virtual void SetID(EntityID id);
 };
\ No newline at end of file
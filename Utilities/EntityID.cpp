@@ -0,0 +1,32 @@
+#include "EntityID.h"
+#include <atomic>
+
+namespace {
+    constexpr uint64_t kBlockSize = 1 << 16;           // ids a thread takes from the shared counter at once
+    std::atomic<uint64_t> next_block{ 1 };             // first id of the next unclaimed block
+
+    struct IdBlock {
+        uint64_t next;
+        uint64_t end;
+    };
+    thread_local IdBlock block{ 0, 0 };
+}
+
+EntityID EntityID::Next() {
+    if (block.next == block.end) {
+        block.next = next_block.fetch_add(kBlockSize, std::memory_order_relaxed);
+        block.end = block.next + kBlockSize;
+    }
+    return EntityID{ block.next++ };
+}
+
+std::string EntityID::ToString() const {
+    static constexpr char kHex[] = "0123456789abcdef";
+    std::string out(16, '0');
+    uint64_t v = value;
+    for (int i = 15; i >= 0; --i) {
+        out[i] = kHex[v & 0xF];
+        v >>= 4;
+    }
+    return out;
+}
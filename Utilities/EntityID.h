@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <string>
+
+/// <EntityID>
+/// compact 64 bit object id, unique within the process and never zero
+/// each thread reserves a block of ids from a shared counter so generating one is a thread local increment
+/// hashing never allocates, ToString formats it only when someone asks
+/// </EntityID>
+struct EntityID {
+    uint64_t value = 0;  // 0 is the invalid id
+
+    //return a fresh id
+    static EntityID Next();
+    //16 hex digits
+    std::string ToString() const;
+
+    explicit operator bool() const { return value != 0; }
+    bool operator==(const EntityID& other) const { return value == other.value; }
+    bool operator!=(const EntityID& other) const { return value != other.value; }
+    bool operator<(const EntityID& other) const { return value < other.value; }
+};
+
+template <>
+struct std::hash<EntityID> {
+    size_t operator()(const EntityID& id) const noexcept {
+        // ids are sequential, mix the bits so they spread over the buckets (splitmix64 finalizer)
+        uint64_t x = id.value;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        return static_cast<size_t>(x ^ (x >> 31));
+    }
+};
@@ -0,0 +1,139 @@
+#include "HighResClock.h"
+#include <mutex>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <cpuid.h>
+#include <x86intrin.h>
+#define HIGHRES_CLOCK_TSC 1
+#else
+#define HIGHRES_CLOCK_TSC 0
+#endif
+
+namespace {
+
+int64_t MonotonicNs() {
+#ifdef _WIN32
+    static const int64_t frequency = [] {
+        LARGE_INTEGER f;
+        QueryPerformanceFrequency(&f);
+        return static_cast<int64_t>(f.QuadPart);
+    }();
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    // split so the multiply cannot overflow
+    int64_t seconds = counter.QuadPart / frequency;
+    int64_t rest = counter.QuadPart % frequency;
+    return seconds * 1000000000 + rest * 1000000000 / frequency;
+#else
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+#if HIGHRES_CLOCK_TSC
+// ns = base_ns + ((tsc - base_tsc) * mult) >> 32
+struct TscCalibration {
+    uint64_t base_tsc = 0;
+    int64_t base_ns = 0;
+    uint64_t mult = 0;
+};
+TscCalibration tsc_calibration;
+std::atomic<bool> tsc_enabled{ false };
+
+bool TscIsInvariant() {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000007) {
+        return false;
+    }
+    __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+    return (edx & (1u << 8)) != 0;
+}
+#endif
+
+} // namespace
+
+HighResClock::HighResClock()
+    : origin_ns_(Now()) {
+}
+
+int64_t HighResClock::Now() {
+#if HIGHRES_CLOCK_TSC
+    if (tsc_enabled.load(std::memory_order_acquire)) {
+        uint64_t ticks = __rdtsc() - tsc_calibration.base_tsc;
+        return tsc_calibration.base_ns + static_cast<int64_t>((static_cast<unsigned __int128>(ticks) * tsc_calibration.mult) >> 32);
+    }
+#endif
+    return MonotonicNs();
+}
+
+bool HighResClock::EnableTsc() {
+#if HIGHRES_CLOCK_TSC
+    static std::once_flag once;
+    std::call_once(once, [] {
+        if (!TscIsInvariant()) return;
+        // spin against the monotonic clock, long enough that the read jitter is well under 1 ppm
+        int64_t ns0 = MonotonicNs();
+        uint64_t tsc0 = __rdtsc();
+        int64_t ns1;
+        do {
+            ns1 = MonotonicNs();
+        } while (ns1 - ns0 < 10000000);
+        uint64_t tsc1 = __rdtsc();
+        if (tsc1 <= tsc0) return;
+
+        tsc_calibration.mult = (static_cast<unsigned __int128>(ns1 - ns0) << 32) / (tsc1 - tsc0);
+        tsc_calibration.base_tsc = tsc1;
+        tsc_calibration.base_ns = ns1;
+        tsc_enabled.store(true, std::memory_order_release);
+    });
+    return tsc_enabled.load(std::memory_order_acquire);
+#else
+    return false;
+#endif
+}
+
+bool HighResClock::UsesTsc() {
+#if HIGHRES_CLOCK_TSC
+    return tsc_enabled.load(std::memory_order_relaxed);
+#else
+    return false;
+#endif
+}
+
+void HighResClock::Reset() {
+    stopped_ns_.store(0, std::memory_order_relaxed);
+    origin_ns_.store(Now(), std::memory_order_release);
+}
+
+void HighResClock::Stop() {
+    if (stopped_ns_.load(std::memory_order_relaxed) == 0) {
+        stopped_ns_.store(Now(), std::memory_order_release);
+    }
+}
+
+void HighResClock::Start() {
+    int64_t stopped = stopped_ns_.load(std::memory_order_relaxed);
+    if (stopped != 0) {
+        origin_ns_.fetch_add(Now() - stopped, std::memory_order_release);
+        stopped_ns_.store(0, std::memory_order_release);
+    }
+}
+
+int64_t HighResClock::ElapsedNs() const {
+    int64_t stopped = stopped_ns_.load(std::memory_order_acquire);
+    int64_t now = stopped != 0 ? stopped : Now();
+    return now - origin_ns_.load(std::memory_order_acquire);
+}
+
+int64_t HighResClock::OriginNs() const {
+    return origin_ns_.load(std::memory_order_acquire);
+}
+
+double HighResClock::TotalTime() const {
+    return static_cast<double>(ElapsedNs()) / 1e6;
+}
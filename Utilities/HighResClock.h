@@ -0,0 +1,41 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/// <HighResClock>
+/// monotonic clock in 64-bit integer nanoseconds, on the same timeline as std::chrono::steady_clock
+/// Now reads clock_gettime(CLOCK_MONOTONIC) on POSIX and QueryPerformanceCounter on Windows,
+/// or rdtsc once EnableTsc found an invariant TSC and calibrated it against the monotonic clock
+/// an instance measures time since Reset with Stop/Start leaving the stopped time out like GameTimer,
+/// reads are lock free, Reset/Stop/Start are meant for one owning thread
+/// </HighResClock>
+class HighResClock {
+public:
+    // Constructor, starts running from now
+    HighResClock();
+
+    // monotonic nanoseconds
+    static int64_t Now();
+    // switch Now to the TSC if it is invariant, calibrates for about 10 ms on the first call, false if unavailable
+    static bool EnableTsc();
+    // return if Now reads the TSC
+    static bool UsesTsc();
+
+    // restart from zero, running
+    void Reset();
+    // freeze the elapsed time
+    void Stop();
+    // continue after Stop, the stopped time does not count
+    void Start();
+    // nanoseconds since Reset, minus the time spent stopped
+    int64_t ElapsedNs() const;
+    // Now() at which ElapsedNs was 0, moves forward by every Stop/Start
+    int64_t OriginNs() const;
+    // ElapsedNs in milliseconds, the unit GameTimer::TotalTime used
+    double TotalTime() const;
+
+private:
+    std::atomic<int64_t> origin_ns_;      // Now() when elapsed was 0
+    std::atomic<int64_t> stopped_ns_{ 0 }; // Now() at Stop, 0 while running
+};
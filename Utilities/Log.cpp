@@ -1,14 +1,77 @@
 #include "Log.h"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
 
+namespace {
+    std::atomic<uint64_t> next_log_instance{ 1 };
 
-Log::Log() {
-    log_file_.open("log.txt", std::ios::out | std::ios::trunc);
-    if (!log_file_.is_open()) {
-        std::cerr << "Failed to open log.txt for writing!" << std::endl;
+    // this thread's ring for one Log, orphaned when the thread exits so the backend can drop it
+    struct ThreadRingSlot {
+        uint64_t instance = 0;
+        std::shared_ptr<LogRing> ring;
+        ~ThreadRingSlot() {
+            if (ring) ring->Orphan();
+        }
+    };
+    thread_local ThreadRingSlot ring_slot;
+
+    // small process wide index of the calling thread, what the log records as the thread
+    std::atomic<uint32_t> next_thread_index{ 0 };
+    uint32_t ThreadIndex() {
+        thread_local uint32_t index = next_thread_index.fetch_add(1, std::memory_order_relaxed);
+        return index;
+    }
+
+    std::string_view LevelString(Log_Level level) {
+        switch (level) {
+        case Log_Level::Debug:
+            return "DEBUG: ";
+        case Log_Level::Info:
+            return "INFO: ";
+        case Log_Level::Warning:
+            return "WARNING: ";
+        case Log_Level::Error:
+            return "ERROR: ";
+        }
+        return "";
+    }
+}
+
+
+Log::Log(Log_Mode mode, Log_Output output)
+    : mode_(mode), output_(output), instance_(next_log_instance.fetch_add(1, std::memory_order_relaxed)) {
+    if (output_ == Log_Output::Binary) {
+        sink_ = std::make_unique<BinaryLogSink>("log");
+        open_ = sink_->IsOpen();
+    }
+    else {
+        log_file_.open("log.txt", std::ios::out | std::ios::trunc);
+        if (!log_file_.is_open()) {
+            std::cerr << "Failed to open log.txt for writing!" << std::endl;
+        }
+        open_ = log_file_.is_open();
+    }
+    try {
+        zone_ = std::chrono::current_zone();
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Logger time zone lookup failed: " << e.what() << std::endl;
+    }
+    if (mode_ == Log_Mode::Async) {
+        backend_ = std::thread([this]() { this->Backend(); });
     }
 }
 
 Log::~Log() {
+    if (backend_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(backend_mutex_);
+            stop_ = true;
+        }
+        backend_cv_.notify_one();
+        backend_.join();  // the backend drains every ring before it exits
+    }
     if (log_file_.is_open()) {
         log_file_.flush();  // Ensure the data is written
         log_file_.close();  // Close the file when done
@@ -16,43 +79,210 @@ Log::~Log() {
 }
 
 void Log::LogInfo(Log_Level level, const std::string& message, std::source_location location) {
-    if (!Log::log_file_.is_open()) {
+    if (!open_) {
         std::cerr << "Log file not open, skipping log entry." << std::endl;
         return;
     }
+    if (!IsEnabled(level)) return;
+    if (mode_ == Log_Mode::Async) {
+        LogAsync(level, message, location);
+    }
+    else {
+        LogSync(level, message, location);
+    }
+}
+
+void Log::Flush() {
+    if (mode_ == Log_Mode::Sync) {
+        std::lock_guard<std::mutex> lock(log_mutex_);
+        if (sink_) sink_->Flush();
+        else log_file_.flush();
+        return;
+    }
+    std::unique_lock<std::mutex> lock(backend_mutex_);
+    uint64_t ticket = ++flush_requested_;
+    backend_cv_.notify_one();
+    flushed_cv_.wait(lock, [&]() { return flushed_ >= ticket; });
+}
 
+void Log::LogSync(Log_Level level, std::string_view message, const std::source_location& location) {
     std::lock_guard<std::mutex> lock(log_mutex_);  // Ensure thread safety
 
-    // Get current time in a readable format
-    auto tp = std::chrono::system_clock::now();
-    auto local_tp = std::chrono::zoned_time{ std::chrono::current_zone(), tp };
-    std::string level_str;
+    std::string line;
+    Emit(line, level, ThreadIndex(), NowNs(), location, message);
+    if (!line.empty()) {
+        log_file_ << line;
 
-    // Determine the LogInfo level string
-    switch (level) {
-    case Log_Level::Info:
-        level_str = "INFO: ";
-        break;
-    case Log_Level::Warning:
-        level_str = "WARNING: ";
-        break;
-    case Log_Level::Error:
-        level_str = "ERROR: ";
-        break;
+        // Flush after writing to ensure it's written immediately
+        log_file_.flush();
     }
+}
 
-    try {
-        // Write to the LogInfo file
-        log_file_ << "[" << level_str << "] "
-            << std::format("{:%F %T %Z}", local_tp)  // Format time
-            << " | " << location.file_name()
-            << ":" << location.function_name()
-            << ":" << location.line()
-            << " | " << message
-            << std::endl;
+std::byte* Log::ReserveRecord(LogRing*& ring, size_t bytes, Log_Level level) {
+    ring = ThreadRing();
+    std::byte* slot = ring->Reserve(bytes);
+    if (slot == nullptr && level == Log_Level::Error) {
+        Flush();  // the backend empties our ring, a record too big for it is still dropped
+        slot = ring->Reserve(bytes);
+    }
+    if (slot == nullptr) {
+        // never wait on the backend, count the loss and hurry it up
+        if (dropped_.fetch_add(1, std::memory_order_relaxed) == 0) {
+            backend_cv_.notify_one();
+        }
+    }
+    return slot;
+}
 
-        // Flush after writing to ensure it's written immediately
-        log_file_.flush();
+void Log::LogAsync(Log_Level level, std::string_view message, const std::source_location& location) {
+    LogRing* ring = nullptr;
+    std::byte* slot = ReserveRecord(ring, sizeof(LogRecord) + message.size(), level);
+    if (slot == nullptr) return;
+
+    LogRecord record{ NowNs(), location, nullptr, nullptr, 0, static_cast<uint32_t>(message.size()), level };
+    std::memcpy(slot, &record, sizeof(LogRecord));
+    std::memcpy(slot + sizeof(LogRecord), message.data(), message.size());
+    ring->Commit(sizeof(LogRecord) + message.size());
+    if (level == Log_Level::Error) {
+        Flush();  // written before we return, like in sync mode
+    }
+}
+
+LogRing* Log::ThreadRing() {
+    if (ring_slot.instance != instance_) {
+        if (ring_slot.ring) ring_slot.ring->Orphan();
+        auto ring = std::make_shared<LogRing>(ThreadIndex());
+        {
+            std::lock_guard<std::mutex> lock(rings_mutex_);
+            rings_.push_back(ring);
+        }
+        ring_slot.instance = instance_;
+        ring_slot.ring = std::move(ring);
+    }
+    return ring_slot.ring.get();
+}
+
+void Log::Backend() {
+    std::string batch;
+    std::unique_lock<std::mutex> lock(backend_mutex_);
+    while (true) {
+        bool stopping = stop_;
+        uint64_t flush_target = flush_requested_;
+        lock.unlock();
+
+        // keep going while passes come back full, a flush has to cover everything logged before it
+        size_t formatted;
+        do {
+            formatted = DrainRings(batch);
+        } while (formatted == kMaxBatch);
+
+        uint64_t dropped = dropped_.exchange(0, std::memory_order_relaxed);
+        if (dropped != 0) {
+            Emit(batch, Log_Level::Warning, ThreadIndex(), NowNs(), std::source_location::current(),
+                std::format("{} log records dropped, ring full", dropped));
+        }
+        if (!batch.empty()) {
+            log_file_.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+            log_file_.flush();
+            batch.clear();
+        }
+
+        lock.lock();
+        if (flush_target > flushed_) {
+            if (sink_) sink_->Flush();
+            flushed_ = flush_target;
+            flushed_cv_.notify_all();
+        }
+        if (stopping) break;
+        backend_cv_.wait_for(lock, kFlushInterval, [this]() { return stop_ || flush_requested_ > flushed_; });
+    }
+}
+
+size_t Log::DrainRings(std::string& batch) {
+    struct Head {
+        LogRing* ring;
+        const std::byte* bytes;
+        LogRecord record;
+    };
+
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    std::vector<Head> heads;
+    heads.reserve(rings_.size());
+    auto peek = [](LogRing* ring, Head& head) {
+        size_t size = 0;
+        head.ring = ring;
+        head.bytes = ring->Peek(size);
+        if (head.bytes) std::memcpy(&head.record, head.bytes, sizeof(LogRecord));
+        return head.bytes != nullptr;
+    };
+    for (auto& ring : rings_) {
+        Head head;
+        if (peek(ring.get(), head)) heads.push_back(head);
+    }
+
+    // merge the rings oldest first, each ring is already in order
+    size_t formatted = 0;
+    while (!heads.empty() && formatted < kMaxBatch) {
+        auto oldest = std::min_element(heads.begin(), heads.end(), [](const Head& a, const Head& b) {
+            return a.record.timestamp_ns < b.record.timestamp_ns;
+        });
+        const std::byte* payload = oldest->bytes + sizeof(LogRecord);
+        std::string_view message;
+        if (oldest->record.format) {
+            // deferred record, format the arguments now that we are off the hot path
+            scratch_.clear();
+            try {
+                oldest->record.format(scratch_, std::string_view(oldest->record.fmt, oldest->record.fmt_bytes), payload);
+            }
+            catch (const std::exception& e) {
+                scratch_ = std::string("log format error: ") + e.what();
+            }
+            message = scratch_;
+        }
+        else {
+            message = std::string_view(reinterpret_cast<const char*>(payload), oldest->record.payload_bytes);
+        }
+        Emit(batch, oldest->record.level, oldest->ring->ThreadIndex(), oldest->record.timestamp_ns, oldest->record.location, message);
+        ++formatted;
+
+        oldest->ring->Release();
+        if (!peek(oldest->ring, *oldest)) {
+            heads.erase(oldest);
+        }
+    }
+
+    // rings whose thread has exited go once they are empty
+    rings_.erase(std::remove_if(rings_.begin(), rings_.end(), [](const std::shared_ptr<LogRing>& ring) {
+        return ring->IsOrphaned() && ring->Empty();
+    }), rings_.end());
+    return formatted;
+}
+
+void Log::Emit(std::string& batch, Log_Level level, uint32_t thread, int64_t timestamp_ns,
+    const std::source_location& location, std::string_view message) {
+    if (sink_) {
+        // no time formatting at all, the decoder does that when someone reads the log
+        sink_->Append(static_cast<char>(level), thread, timestamp_ns, location.file_name(),
+            location.function_name(), location.line(), message);
+    }
+    else {
+        FormatLine(batch, level, timestamp_ns, location, message);
+    }
+}
+
+void Log::FormatLine(std::string& out, Log_Level level, int64_t timestamp_ns,
+    const std::source_location& location, std::string_view message) {
+    try {
+        std::chrono::sys_time<std::chrono::nanoseconds> tp{ std::chrono::nanoseconds(timestamp_ns) };
+        auto it = std::back_inserter(out);
+        it = std::format_to(it, "[{}] ", LevelString(level));
+        if (zone_) {
+            it = std::format_to(it, "{:%F %T %Z}", std::chrono::zoned_time{ zone_, tp });  // Format time
+        }
+        else {
+            it = std::format_to(it, "{:%F %T} UTC", tp);
+        }
+        std::format_to(it, " | {}:{}:{} | {}\n", location.file_name(), location.function_name(), location.line(), message);
     }
     catch (const std::exception& e) {
         std::cerr << "Logger format error: " << e.what() << std::endl;
@@ -5,25 +5,151 @@
 #include <format>
 #include <fstream>
 #include <string>
+#include <string_view>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <thread>
+#include <vector>
 #include <mutex>  // For thread safety
+#include "LogRing.h"
+#include "LogArgs.h"
+#include "BinaryLogSink.h"
 
 enum class Log_Level : char {
+    Debug = 'D',
     Info = 'I',
     Warning = 'W',
     Error = 'E'
 };
 
+// severity order for filtering, the enum values are the letters written to the log
+constexpr int LevelRank(Log_Level level) {
+    switch (level) {
+    case Log_Level::Debug: return 0;
+    case Log_Level::Info: return 1;
+    case Log_Level::Warning: return 2;
+    case Log_Level::Error: return 3;
+    }
+    return 3;
+}
+
+enum class Log_Mode {
+    Sync,   // format and write on the calling thread under a lock
+    Async   // copy a binary record into a per thread ring, a backend thread formats and writes
+};
+
+enum class Log_Output {
+    Text,   // formatted lines in log.txt
+    Binary  // BinaryLogFormat records in memory mapped log.N.bin segments, read them with LogDecode
+};
+
+/// <Log>
+/// sync is the default, async is opted into through the constructor or Logger::Init
+/// in async mode LogInfo never takes a lock or touches the file, it only copies the record into
+/// the calling thread's LogRing. the backend thread merges the rings by timestamp, formats the
+/// lines and writes them in one batch every few milliseconds. a full ring drops the record
+/// and the backend reports how many were lost. an error waits for room instead of being dropped
+/// and returns only once it is written, so the last line before a crash makes it to the file
+/// Write keeps the format arguments in binary and formats them on the backend,
+/// use it through the LOG_ macros in Logger.h so filtered calls cost nothing
+/// </Log>
 class Log {
 public:
-    Log();
+    Log(Log_Mode mode = Log_Mode::Sync, Log_Output output = Log_Output::Text);
     Log(const Log&) = delete;
     Log& operator=(const Log&) = delete;
     ~Log();
 
     void LogInfo(Log_Level level, const std::string& message, std::source_location location = std::source_location::current());
+    // log fmt with args, formatting is deferred to the backend in async mode
+    template <typename... Args>
+    void Write(Log_Level level, const std::source_location& location, std::format_string<Args...> fmt, Args&&... args);
+    // block until everything logged before the call is written
+    void Flush();
+    // runtime minimum level, one relaxed load per check
+    bool IsEnabled(Log_Level level) const {
+        return LevelRank(level) >= min_level_.load(std::memory_order_relaxed);
+    }
+    void SetLevel(Log_Level level) { min_level_.store(LevelRank(level), std::memory_order_relaxed); }
 
 private:
-    
+    // fixed part of an async record, the payload follows it in the ring
+    struct LogRecord {
+        int64_t timestamp_ns;          // system clock
+        std::source_location location;
+        LogArgs::FormatFn format;      // null when the payload is the finished message
+        const char* fmt;               // format string, static storage
+        uint32_t fmt_bytes;
+        uint32_t payload_bytes;
+        Log_Level level;
+    };
+    static constexpr size_t kMaxBatch = 4096;  // records formatted per backend pass
+    static constexpr std::chrono::milliseconds kFlushInterval{ 5 };
+
+    void LogSync(Log_Level level, std::string_view message, const std::source_location& location);
+    void LogAsync(Log_Level level, std::string_view message, const std::source_location& location);
+    // room for a record in the calling thread's ring, nullptr and counted as dropped when full
+    // an error flushes the ring and tries again instead
+    std::byte* ReserveRecord(LogRing*& ring, size_t bytes, Log_Level level);
+    static int64_t NowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+    // the calling thread's ring, registered on first use
+    LogRing* ThreadRing();
+    // backend thread loop
+    void Backend();
+    // format up to kMaxBatch records from all rings into batch, oldest first
+    size_t DrainRings(std::string& batch);
+    void FormatLine(std::string& out, Log_Level level, int64_t timestamp_ns,
+        const std::source_location& location, std::string_view message);
+    // hand one finished record to the output, text goes into batch, binary straight to the sink
+    void Emit(std::string& batch, Log_Level level, uint32_t thread, int64_t timestamp_ns,
+        const std::source_location& location, std::string_view message);
+
     std::ofstream log_file_;  // Declaration of the static member
     std::mutex log_mutex_;    // Mutex for thread safety
-};
\ No newline at end of file
+    Log_Mode mode_;
+    Log_Output output_;
+    bool open_ = false;                               // the output opened, set once in the constructor
+    std::unique_ptr<BinaryLogSink> sink_;             // Binary output only
+    std::atomic<int> min_level_{ 0 };                 // LevelRank of the lowest level written
+    std::string scratch_;                             // backend, deferred messages are formatted here
+    uint64_t instance_;                               // tells thread local ring caches of different logs apart
+    const std::chrono::time_zone* zone_ = nullptr;    // looked up once, not per line
+    std::vector<std::shared_ptr<LogRing>> rings_;     // guarded by rings_mutex_
+    std::mutex rings_mutex_;
+    std::atomic<uint64_t> dropped_{ 0 };              // records lost to a full ring
+    uint64_t flush_requested_ = 0;                    // guarded by backend_mutex_
+    uint64_t flushed_ = 0;                            // guarded by backend_mutex_
+    bool stop_ = false;                               // guarded by backend_mutex_
+    std::mutex backend_mutex_;
+    std::condition_variable backend_cv_;  // wakes the backend early for Flush and stop
+    std::condition_variable flushed_cv_;  // Flush waits on this
+    std::thread backend_;
+};
+
+template <typename... Args>
+void Log::Write(Log_Level level, const std::source_location& location, std::format_string<Args...> fmt, Args&&... args) {
+    if (!IsEnabled(level) || !open_) return;
+    if (mode_ == Log_Mode::Sync) {
+        LogSync(level, std::format(fmt, std::forward<Args>(args)...), location);
+        return;
+    }
+
+    size_t payload = LogArgs::Size(args...);
+    LogRing* ring = nullptr;
+    std::byte* slot = ReserveRecord(ring, sizeof(LogRecord) + payload, level);
+    if (slot == nullptr) return;
+
+    std::string_view format = fmt.get();
+    LogRecord record{ NowNs(), location, &LogArgs::Format<std::decay_t<Args>...>,
+        format.data(), static_cast<uint32_t>(format.size()), static_cast<uint32_t>(payload), level };
+    std::memcpy(slot, &record, sizeof(LogRecord));
+    LogArgs::Encode(slot + sizeof(LogRecord), args...);
+    ring->Commit(sizeof(LogRecord) + payload);
+    if (level == Log_Level::Error) {
+        Flush();  // written before we return, like in sync mode
+    }
+}
\ No newline at end of file
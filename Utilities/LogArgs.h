@@ -0,0 +1,120 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+/// <LogArgs>
+/// encodes log arguments into a ring record so the backend can format them later
+/// strings are copied as length prefixed bytes, trivially copyable values as raw bytes,
+/// anything else is formatted to a string on the producer once the record passed the filter
+/// </LogArgs>
+namespace LogArgs {
+
+    // formats the encoded arguments of one record, instantiated per argument list
+    using FormatFn = void (*)(std::string& out, std::string_view fmt, const std::byte* payload);
+
+    template <typename T, typename = void>
+    struct Codec {
+        // fallback, format now and ship the text (formats twice, keep such types off hot paths)
+        static std::string Text(const T& value) { return std::format("{}", value); }
+        static size_t Size(const T& value) { return sizeof(uint32_t) + Text(value).size(); }
+        static std::byte* Encode(std::byte* out, const T& value) {
+            std::string text = Text(value);
+            uint32_t bytes = static_cast<uint32_t>(text.size());
+            std::memcpy(out, &bytes, sizeof(bytes));
+            std::memcpy(out + sizeof(bytes), text.data(), bytes);
+            return out + sizeof(bytes) + bytes;
+        }
+        static std::string_view Decode(const std::byte*& in) {
+            uint32_t bytes;
+            std::memcpy(&bytes, in, sizeof(bytes));
+            std::string_view text(reinterpret_cast<const char*>(in + sizeof(bytes)), bytes);
+            in += sizeof(bytes) + bytes;
+            return text;
+        }
+    };
+
+    // numbers, enums and other plain values are copied as they are
+    template <typename T>
+    struct Codec<T, std::enable_if_t<std::is_trivially_copyable_v<T> && !std::is_pointer_v<T>>> {
+        static size_t Size(const T&) { return sizeof(T); }
+        static std::byte* Encode(std::byte* out, const T& value) {
+            std::memcpy(out, &value, sizeof(T));
+            return out + sizeof(T);
+        }
+        static T Decode(const std::byte*& in) {
+            T value;
+            std::memcpy(&value, in, sizeof(T));
+            in += sizeof(T);
+            return value;
+        }
+    };
+
+    // strings may not outlive the call, copy the characters
+    struct StringCodec {
+        static size_t Size(std::string_view text) { return sizeof(uint32_t) + text.size(); }
+        static std::byte* Encode(std::byte* out, std::string_view text) {
+            uint32_t bytes = static_cast<uint32_t>(text.size());
+            std::memcpy(out, &bytes, sizeof(bytes));
+            std::memcpy(out + sizeof(bytes), text.data(), bytes);
+            return out + sizeof(bytes) + bytes;
+        }
+        static std::string_view Decode(const std::byte*& in) {
+            uint32_t bytes;
+            std::memcpy(&bytes, in, sizeof(bytes));
+            std::string_view text(reinterpret_cast<const char*>(in + sizeof(bytes)), bytes);
+            in += sizeof(bytes) + bytes;
+            return text;
+        }
+    };
+    template <> struct Codec<std::string> : StringCodec {};
+    template <> struct Codec<std::string_view> : StringCodec {};
+    template <> struct Codec<const char*> : StringCodec {};
+    template <> struct Codec<char*> : StringCodec {};
+
+    // other pointers are logged as addresses
+    template <typename T>
+    struct Codec<T*, std::enable_if_t<!std::is_same_v<std::remove_cv_t<T>, char>>> {
+        static size_t Size(T*) { return sizeof(const void*); }
+        static std::byte* Encode(std::byte* out, T* value) {
+            const void* address = value;
+            std::memcpy(out, &address, sizeof(address));
+            return out + sizeof(address);
+        }
+        static const void* Decode(const std::byte*& in) {
+            const void* address;
+            std::memcpy(&address, in, sizeof(address));
+            in += sizeof(address);
+            return address;
+        }
+    };
+
+    template <typename T>
+    using CodecOf = Codec<std::decay_t<T>>;
+
+    // bytes needed to encode all of args
+    template <typename... Args>
+    size_t Size(const Args&... args) {
+        return (size_t{ 0 } + ... + CodecOf<Args>::Size(args));
+    }
+
+    template <typename... Args>
+    void Encode(std::byte* out, const Args&... args) {
+        ((out = CodecOf<Args>::Encode(out, args)), ...);
+    }
+
+    template <typename... Args>
+    void Format(std::string& out, std::string_view fmt, const std::byte* payload) {
+        // braced init runs the decoders left to right
+        std::tuple<decltype(CodecOf<Args>::Decode(payload))...> values{ CodecOf<Args>::Decode(payload)... };
+        std::apply([&](auto&... value) {
+            std::vformat_to(std::back_inserter(out), fmt, std::make_format_args(value...));
+        }, values);
+    }
+}
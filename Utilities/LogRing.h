@@ -0,0 +1,117 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+/// <LogRing>
+/// single producer single consumer byte ring for variable sized log records
+/// the owning thread reserves and commits records, the log backend peeks and releases them
+/// a record never wraps, when it does not fit before the end the rest is skipped with a pad frame
+/// </LogRing>
+class LogRing {
+public:
+    // Constructor, capacity is rounded up to a power of two
+    explicit LogRing(uint32_t thread_index, size_t capacity = 1 << 18)
+        : thread_index_(thread_index) {
+        size_t rounded = 64;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        capacity_ = rounded;
+        mask_ = rounded - 1;
+        buffer_.reset(new std::byte[rounded]);
+    }
+    LogRing(const LogRing& other) = delete;
+    LogRing& operator=(const LogRing& other) = delete;
+
+    // space for a record of bytes, nullptr when the ring is full (producer only)
+    std::byte* Reserve(size_t bytes) {
+        size_t frame = FrameSize(bytes);
+        if (frame > capacity_ / 2) return nullptr;  // a record that big would starve the ring
+
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        size_t offset = static_cast<size_t>(head & mask_);
+        size_t contiguous = capacity_ - offset;
+        size_t needed = contiguous < frame ? contiguous + frame : frame;
+
+        if (needed > capacity_ - static_cast<size_t>(head - cached_tail_)) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (needed > capacity_ - static_cast<size_t>(head - cached_tail_)) {
+                return nullptr;
+            }
+        }
+
+        if (contiguous < frame) {
+            // skip to the start of the buffer, the consumer jumps the pad frame
+            WriteFrame(offset, static_cast<uint32_t>(contiguous), kPad);
+            head += contiguous;
+            offset = 0;
+        }
+        reserved_ = head;
+        WriteFrame(offset, static_cast<uint32_t>(frame), 0);
+        return buffer_.get() + offset + sizeof(Frame);
+    }
+    // publish the record returned by the last Reserve (producer only)
+    void Commit(size_t bytes) {
+        head_.store(reserved_ + FrameSize(bytes), std::memory_order_release);
+    }
+
+    // the oldest record and its size, nullptr when empty (consumer only)
+    const std::byte* Peek(size_t& bytes) {
+        while (true) {
+            uint64_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail == head_.load(std::memory_order_acquire)) {
+                return nullptr;
+            }
+            Frame frame;
+            std::memcpy(&frame, buffer_.get() + (tail & mask_), sizeof(Frame));
+            if (frame.flags & kPad) {
+                tail_.store(tail + frame.size, std::memory_order_release);
+                continue;
+            }
+            bytes = frame.size - sizeof(Frame);
+            peeked_ = frame.size;
+            return buffer_.get() + (tail & mask_) + sizeof(Frame);
+        }
+    }
+    // drop the record returned by the last Peek (consumer only)
+    void Release() {
+        tail_.store(tail_.load(std::memory_order_relaxed) + peeked_, std::memory_order_release);
+    }
+
+    uint32_t ThreadIndex() const { return thread_index_; }
+    // the producer thread exited, the backend may drop the ring once it is drained
+    void Orphan() { orphaned_.store(true, std::memory_order_release); }
+    bool IsOrphaned() const { return orphaned_.load(std::memory_order_acquire); }
+    bool Empty() const {
+        return tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_acquire);
+    }
+
+private:
+    struct Frame {
+        uint32_t size;   // frame bytes including this header, multiple of 8
+        uint32_t flags;
+    };
+    static constexpr uint32_t kPad = 1;
+
+    static size_t FrameSize(size_t bytes) {
+        return (sizeof(Frame) + bytes + 7) & ~size_t(7);
+    }
+    void WriteFrame(size_t offset, uint32_t size, uint32_t flags) {
+        Frame frame{ size, flags };
+        std::memcpy(buffer_.get() + offset, &frame, sizeof(Frame));
+    }
+
+    alignas(64) std::atomic<uint64_t> head_{ 0 };  // producer writes here
+    uint64_t reserved_ = 0;                         // producer, start of the reserved frame
+    uint64_t cached_tail_ = 0;                      // producer, last tail it saw
+    alignas(64) std::atomic<uint64_t> tail_{ 0 };  // consumer reads here
+    size_t peeked_ = 0;                             // consumer, size of the peeked frame
+    alignas(64) std::unique_ptr<std::byte[]> buffer_;
+    size_t capacity_ = 0;
+    size_t mask_ = 0;
+    uint32_t thread_index_;                         // small id of the producer thread
+    std::atomic<bool> orphaned_{ false };
+};
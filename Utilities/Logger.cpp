@@ -1,9 +1,23 @@
 #include "Logger.h"
 
 std::shared_ptr<Log> Logger::logger_ = nullptr;
+std::once_flag Logger::once_;
 
 std::shared_ptr<Log> Logger::Get() {
-	if (!logger_)
-		logger_ = std::make_shared<Log>();
+	std::call_once(once_, []() { logger_ = std::make_shared<Log>(); });
 	return logger_;
 }
+
+bool Logger::Init(Log_Mode mode, Log_Output output) {
+	bool created = false;
+	std::call_once(once_, [&]() {
+		logger_ = std::make_shared<Log>(mode, output);
+		created = true;
+	});
+	return created;
+}
+
+Log& Logger::Instance() {
+	std::call_once(once_, []() { logger_ = std::make_shared<Log>(); });
+	return *logger_;
+}
@@ -1,6 +1,15 @@
 #pragma once
 #include "Log.h"
 
+// lowest level compiled in, calls below it are removed entirely
+#ifndef LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define LOG_MIN_LEVEL Log_Level::Info
+#else
+#define LOG_MIN_LEVEL Log_Level::Debug
+#endif
+#endif
+
 class Logger {
 public:
     // Delete the constructor so no one else can create instances of this manager
@@ -12,7 +21,29 @@ public:
 
     // Singleton accessor
     static std::shared_ptr<Log> Get();
+    // Singleton accessor without the shared_ptr copy, for the LOG_ macros
+    static Log& Instance();
+    // create the singleton with these settings before anything logs, false if it already exists
+    static bool Init(Log_Mode mode, Log_Output output);
 private:
     static std::shared_ptr<Log> logger_;  // The singleton TaskScheduler instance
+    static std::once_flag once_;
 };
 
+// log through the singleton, the arguments are only evaluated when the level is enabled
+// and only formatted on the log backend, e.g. LOG_DEBUG("task {} queued", id.value)
+#define LOG_AT(level, ...) \
+    do { \
+        if constexpr (LevelRank(level) >= LevelRank(LOG_MIN_LEVEL)) { \
+            Log& log_at_ = Logger::Instance(); \
+            if (log_at_.IsEnabled(level)) { \
+                log_at_.Write(level, std::source_location::current(), __VA_ARGS__); \
+            } \
+        } \
+    } while (0)
+
+#define LOG_DEBUG(...) LOG_AT(Log_Level::Debug, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(Log_Level::Info, __VA_ARGS__)
+#define LOG_WARNING(...) LOG_AT(Log_Level::Warning, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(Log_Level::Error, __VA_ARGS__)
+